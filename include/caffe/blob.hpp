@@ -262,6 +262,15 @@ class Blob {
    * shared_ptr calls its destructor when reset with the "=" operator.
    */
   void ShareDiff(const Blob& other);
+  /**
+   * @brief Set the data_ shared_ptr to point to data, which must be large
+   *        enough for this Blob's count and may back other Blob%s too.
+   *
+   * This deallocates the SyncedMemory holding this Blob's data_. The
+   * capacity shrinks to what data holds if need be, and reshaping beyond it
+   * later gives the Blob its own memory again.
+   */
+  void ShareDataMemory(const shared_ptr<SyncedMemory>& data);
 
   bool ShapeEquals(const BlobProto& other);
 
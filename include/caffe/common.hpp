@@ -70,6 +70,9 @@ namespace cv { class Mat; }
 
 namespace caffe {
 
+class SyncedMemory;
+class ThreadPool;
+
 // We will use the boost shared_ptr instead of the new C++11 one mainly
 // because cuda does not work (at least now) well with C++11 features.
 using boost::shared_ptr;
@@ -154,6 +157,27 @@ class Caffe {
   inline static void set_solver_count(int val) { Get().solver_count_ = val; }
   inline static bool root_solver() { return Get().root_solver_; }
   inline static void set_root_solver(bool val) { Get().root_solver_ = val; }
+  // The pool CPU layers split their loops across (see parallel_for in
+  // caffe/util/thread_pool.hpp). Unlike the rest of this class it is shared
+  // by all threads of the process; it starts with a single thread.
+  static ThreadPool& thread_pool();
+  static int cpu_threads();
+  // Sets the number of threads of the pool, including the calling one.
+  // Don't call it while another thread may be inside parallel_for.
+  static void set_cpu_threads(int threads);
+  // Scratch memory of at least size bytes for temporary results that do not
+  // outlive one Forward or Backward call, such as the column buffers of
+  // convolution. Each thread has one workspace shared by all its layers; it
+  // only grows, so it holds the largest request rather than the sum of them.
+  // The memory is only valid until the next call for the same side. Host and
+  // device each get their own buffer, to be used only through that side's
+  // pointer, so scratch is never copied between them.
+  static SyncedMemory* cpu_workspace(size_t size);
+#ifndef CPU_ONLY
+  static SyncedMemory* gpu_workspace(size_t size);
+#endif
+  // Frees the workspaces of the calling thread.
+  static void release_workspace();
 
  protected:
 #ifndef CPU_ONLY
@@ -161,6 +185,8 @@ class Caffe {
   curandGenerator_t curand_generator_;
 #endif
   shared_ptr<RNG> random_generator_;
+  shared_ptr<SyncedMemory> cpu_workspace_;
+  shared_ptr<SyncedMemory> gpu_workspace_;
 
   Brew mode_;
   int solver_count_;
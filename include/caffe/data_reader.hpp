@@ -8,6 +8,7 @@
 #include "caffe/common.hpp"
 #include "caffe/internal_thread.hpp"
 #include "caffe/util/blocking_queue.hpp"
+#include "caffe/util/bounded_queue.hpp"
 #include "caffe/util/db.hpp"
 
 namespace caffe {
@@ -19,16 +20,21 @@ namespace caffe {
  * databases are read sequentially, and that each solver accesses a different
  * subset of the database. Data is distributed to solvers in a round-robin
  * way to keep parallel training deterministic.
+ *
+ * With data_param.reader_threads > 1 the source is split into that many
+ * ranges of consecutive records, each read and parsed by its own thread
+ * and cursor. The body then takes records from the ranges in turn. With
+ * data_param.shuffle each range is read in a random order of blocks.
  */
 class DataReader {
  public:
   explicit DataReader(const LayerParameter& param);
   ~DataReader();
 
-  inline BlockingQueue<Datum*>& free() const {
+  inline BoundedQueue<Datum*>& free() const {
     return queue_pair_->free_;
   }
-  inline BlockingQueue<Datum*>& full() const {
+  inline BoundedQueue<Datum*>& full() const {
     return queue_pair_->full_;
   }
 
@@ -39,12 +45,37 @@ class DataReader {
     explicit QueuePair(int size);
     ~QueuePair();
 
-    BlockingQueue<Datum*> free_;
-    BlockingQueue<Datum*> full_;
+    BoundedQueue<Datum*> free_;
+    BoundedQueue<Datum*> full_;
 
   DISABLE_COPY_AND_ASSIGN(QueuePair);
   };
 
+  // Reads a range of size records, over and over, into its queues. The
+  // range is made of blocks of block_size records starting at block_keys.
+  class Shard : public InternalThread {
+   public:
+    Shard(db::Cursor* cursor, const vector<string>& block_keys,
+        int block_size, int size, const DataParameter& param);
+    virtual ~Shard();
+
+    int size() const { return size_; }
+
+    BoundedQueue<Datum*> free_;
+    BoundedQueue<Datum*> full_;
+
+   protected:
+    void InternalThreadEntry();
+
+    shared_ptr<db::Cursor> cursor_;
+    const vector<string> block_keys_;
+    const int block_size_;
+    const int size_;
+    const DataParameter param_;
+
+  DISABLE_COPY_AND_ASSIGN(Shard);
+  };
+
   // A single body is created per source
   class Body : public InternalThread {
    public:
@@ -54,9 +85,16 @@ class DataReader {
    protected:
     void InternalThreadEntry();
     void read_one(db::Cursor* cursor, QueuePair* qp);
+    void read_one(Shard* shard, QueuePair* qp);
+    // Splits the source into ranges of about the same number of blocks.
+    void StartShards(db::DB* db, int num_shards);
 
     const LayerParameter param_;
     BlockingQueue<shared_ptr<QueuePair> > new_queue_pairs_;
+    vector<shared_ptr<Shard> > shards_;
+    int next_shard_;
+    // The records each shard has yet to hand out in the current epoch.
+    vector<int> shard_remaining_;
 
     friend class DataReader;
 
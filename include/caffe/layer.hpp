@@ -294,6 +294,15 @@ class Layer {
     return true;
   }
 
+  /**
+   * @brief Return whether this layer may make its top blobs share the data
+   *        of its bottom blobs, as e.g. SplitLayer does, instead of computing
+   *        them into their own memory.
+   *
+   * Net's activation memory sharing keeps such blobs alive together.
+   */
+  virtual inline bool SharesBottomData() const { return false; }
+
   /**
    * @brief Specifies whether the layer should compute gradients w.r.t. a
    *        parameter at a particular index given by param_id.
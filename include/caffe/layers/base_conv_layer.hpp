@@ -40,6 +40,15 @@ class BaseConvolutionLayer : public Layer<Dtype> {
   void weight_cpu_gemm(const Dtype* input, const Dtype* output, Dtype*
       weights);
   void backward_cpu_bias(Dtype* bias, const Dtype* input);
+  // Counterparts of the above for batch consecutive images, which are
+  // unrolled side by side and handled with one gemm per group. batch may be
+  // at most col_batch_; with batch == 1 they fall back to the above.
+  void forward_cpu_gemm_batch(const Dtype* input, const Dtype* weights,
+      Dtype* output, int batch);
+  void backward_cpu_gemm_batch(const Dtype* output, const Dtype* weights,
+      Dtype* input, int batch);
+  void weight_cpu_gemm_batch(const Dtype* input, const Dtype* output,
+      Dtype* weights, int batch);
 
 #ifndef CPU_ONLY
   void forward_gpu_gemm(const Dtype* col_input, const Dtype* weights,
@@ -90,8 +99,24 @@ class BaseConvolutionLayer : public Layer<Dtype> {
   int weight_offset_;
   int num_output_;
   bool bias_term_;
+  bool fused_relu_;
   bool is_1x1_;
   bool force_nd_im2col_;
+  /// @brief The number of images the CPU gemm helpers take at once.
+  int col_batch_;
+
+  /// @brief Borrow scratch for count elements from Caffe::cpu_workspace() or
+  ///        Caffe::gpu_workspace(); it is only valid until the next borrow.
+  inline Dtype* workspace_cpu(int count) {
+    return static_cast<Dtype*>(
+        Caffe::cpu_workspace(count * sizeof(Dtype))->mutable_cpu_data());
+  }
+#ifndef CPU_ONLY
+  inline Dtype* workspace_gpu(int count) {
+    return static_cast<Dtype*>(
+        Caffe::gpu_workspace(count * sizeof(Dtype))->mutable_gpu_data());
+  }
+#endif
 
  private:
   // wrap im2col/col2im so we don't have to remember the (long) argument lists
@@ -123,6 +148,35 @@ class BaseConvolutionLayer : public Layer<Dtype> {
           pad_.cpu_data(), stride_.cpu_data(), dilation_.cpu_data(), data);
     }
   }
+  // The same for the 2D im2col/col2im of batched column buffers, in which
+  // each row holds the columns of all images and is col_stride long.
+  inline void conv_im2col_cpu(const Dtype* data, int col_stride,
+      Dtype* col_buff) {
+    im2col_cpu(data, conv_in_channels_,
+        conv_input_shape_.cpu_data()[1], conv_input_shape_.cpu_data()[2],
+        kernel_shape_.cpu_data()[0], kernel_shape_.cpu_data()[1],
+        pad_.cpu_data()[0], pad_.cpu_data()[1],
+        stride_.cpu_data()[0], stride_.cpu_data()[1],
+        dilation_.cpu_data()[0], dilation_.cpu_data()[1], col_stride,
+        col_buff);
+  }
+  inline void conv_col2im_cpu(const Dtype* col_buff, int col_stride,
+      Dtype* data) {
+    col2im_cpu(col_buff, conv_in_channels_,
+        conv_input_shape_.cpu_data()[1], conv_input_shape_.cpu_data()[2],
+        kernel_shape_.cpu_data()[0], kernel_shape_.cpu_data()[1],
+        pad_.cpu_data()[0], pad_.cpu_data()[1],
+        stride_.cpu_data()[0], stride_.cpu_data()[1],
+        dilation_.cpu_data()[0], dilation_.cpu_data()[1], col_stride, data);
+  }
+  // Gather (scatter) the conv_out_channels_ x conv_out_spatial_dim_ outputs
+  // of batch images to (from) the rows of a batched output buffer.
+  void gather_outputs(const Dtype* output, int batch, Dtype* output_buff);
+  void scatter_outputs(const Dtype* output_buff, int batch, Dtype* output);
+  // Borrow the column buffer of batch images, followed by their output
+  // buffer, from the workspace.
+  Dtype* batch_workspace_cpu(int batch);
+
 #ifndef CPU_ONLY
   inline void conv_im2col_gpu(const Dtype* data, Dtype* col_buff) {
     if (!force_nd_im2col_ && num_spatial_axes_ == 2) {
@@ -165,6 +219,8 @@ class BaseConvolutionLayer : public Layer<Dtype> {
   int col_offset_;
   int output_offset_;
 
+  /// Only holds the shape of the column buffer; its memory is borrowed from
+  /// the workspace, as are the batched column and output buffers.
   Blob<Dtype> col_buffer_;
   Blob<Dtype> bias_multiplier_;
 };
@@ -8,7 +8,7 @@
 #include "caffe/internal_thread.hpp"
 #include "caffe/layer.hpp"
 #include "caffe/proto/caffe.pb.h"
-#include "caffe/util/blocking_queue.hpp"
+#include "caffe/util/bounded_queue.hpp"
 
 namespace caffe {
 
@@ -67,16 +67,35 @@ class BasePrefetchingDataLayer :
   virtual void Forward_gpu(const vector<Blob<Dtype>*>& bottom,
       const vector<Blob<Dtype>*>& top);
 
-  // Prefetches batches (asynchronously if to GPU memory)
-  static const int PREFETCH_COUNT = 3;
+  // The number of batches prefetched (asynchronously if to GPU memory),
+  // data_param().prefetch() to begin with. If data_param().max_prefetch()
+  // is larger, a batch is added, up to that many, whenever Forward has to
+  // wait for one, which absorbs variations in load time.
+  int prefetch_count() const { return prefetch_.size(); }
+  // The number of Forward calls, how many of them found no prefetched batch
+  // and waited for one, and their total wait. Waiting often means training
+  // is bound by the input.
+  int forward_count() const { return forward_count_; }
+  int wait_count() const { return wait_count_; }
+  double wait_ms() const { return wait_ms_; }
 
  protected:
   virtual void InternalThreadEntry();
   virtual void load_batch(Batch<Dtype>* batch) = 0;
+  // Takes the next prefetched batch, waiting for it if need be.
+  Batch<Dtype>* NextBatch();
 
-  Batch<Dtype> prefetch_[PREFETCH_COUNT];
-  BlockingQueue<Batch<Dtype>*> prefetch_free_;
-  BlockingQueue<Batch<Dtype>*> prefetch_full_;
+  vector<shared_ptr<Batch<Dtype> > > prefetch_;
+  // In GPU mode, the batches the queue may still grow by. They get their
+  // memory in LayerSetUp, so growing never calls cudaMalloc mid-iteration.
+  vector<shared_ptr<Batch<Dtype> > > prefetch_spare_;
+  const int max_prefetch_;
+  // Never hold more than the max_prefetch_ batches.
+  BoundedQueue<Batch<Dtype>*> prefetch_free_;
+  BoundedQueue<Batch<Dtype>*> prefetch_full_;
+  int forward_count_;
+  int wait_count_;
+  double wait_ms_;
 
   Blob<Dtype> transformed_data_;
 };
@@ -58,8 +58,10 @@ class ConvolutionLayer : public BaseConvolutionLayer<Dtype> {
    *  first group and input channels 3-4 and output channels 5-8 into the second
    *  group.
    *  - bias_term (\b optional, default true). Whether to have a bias.
-   *  - engine: convolution has CAFFE (matrix multiplication) and CUDNN (library
-   *    kernels + stream parallelism) engines.
+   *  - engine: convolution has CAFFE (matrix multiplication), CUDNN (library
+   *    kernels + stream parallelism), DIRECT (tiled CPU matrix
+   *    multiplication without a whole-image column buffer), and WINOGRAD
+   *    (CPU minimal filtering for 3x3 stride 1 kernels) engines.
    */
   explicit ConvolutionLayer(const LayerParameter& param)
       : BaseConvolutionLayer<Dtype>(param) {}
@@ -77,6 +79,15 @@ class ConvolutionLayer : public BaseConvolutionLayer<Dtype> {
       const vector<bool>& propagate_down, const vector<Blob<Dtype>*>& bottom);
   virtual inline bool reverse_dimensions() { return false; }
   virtual void compute_output_shape();
+
+  /// @brief Apply the fused ReLU, if any, to the output of one image.
+  void forward_cpu_relu(Dtype* output);
+  /// @brief Zero the diff where the fused ReLU, if any, clamped top's data.
+  void backward_cpu_relu(Blob<Dtype>* top);
+#ifndef CPU_ONLY
+  void forward_gpu_relu(Dtype* output);
+  void backward_gpu_relu(Blob<Dtype>* top);
+#endif
 };
 
 }  // namespace caffe
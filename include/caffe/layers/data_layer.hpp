@@ -1,6 +1,8 @@
 #ifndef CAFFE_DATA_LAYER_HPP_
 #define CAFFE_DATA_LAYER_HPP_
 
+#include <boost/date_time/posix_time/posix_time.hpp>
+
 #include <vector>
 
 #include "caffe/blob.hpp"
@@ -10,7 +12,9 @@
 #include "caffe/layer.hpp"
 #include "caffe/layers/base_data_layer.hpp"
 #include "caffe/proto/caffe.pb.h"
+#include "caffe/util/blocking_queue.hpp"
 #include "caffe/util/db.hpp"
+#include "caffe/util/thread_pool.hpp"
 
 namespace caffe {
 
@@ -30,8 +34,26 @@ class DataLayer : public BasePrefetchingDataLayer<Dtype> {
 
  protected:
   virtual void load_batch(Batch<Dtype>* batch);
+  // With deterministic_decode, transforms the items of the workers
+  // [worker_begin, worker_end): worker w takes items w, w + workers, ...
+  // with its own transformer. Otherwise [begin, end) are items, transformed
+  // with whichever transformer is idle.
+  void TransformItems(Dtype* top_data, Dtype* top_label, Datum** datums,
+      int begin, int end);
+  void TransformItem(DataTransformer<Dtype>* transformer,
+      Blob<Dtype>* transformed_blob, Dtype* top_data, Dtype* top_label,
+      Datum* datum, int item_id);
 
   DataReader reader_;
+  // One per decode thread; the first transformer is data_transformer_.
+  vector<shared_ptr<DataTransformer<Dtype> > > transformers_;
+  vector<shared_ptr<Blob<Dtype> > > transformed_blobs_;
+  BlockingQueue<int> idle_transformers_;
+  shared_ptr<ThreadPool> decode_pool_;
+  // Items loaded and time spent loading them since throughput was logged.
+  int loaded_items_;
+  double load_time_;
+  boost::posix_time::ptime last_log_;
 };
 
 }  // namespace caffe
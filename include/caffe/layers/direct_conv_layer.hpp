@@ -0,0 +1,67 @@
+#ifndef CAFFE_DIRECT_CONV_LAYER_HPP_
+#define CAFFE_DIRECT_CONV_LAYER_HPP_
+
+#include <vector>
+
+#include "caffe/blob.hpp"
+#include "caffe/layer.hpp"
+#include "caffe/proto/caffe.pb.h"
+
+#include "caffe/layers/conv_layer.hpp"
+
+namespace caffe {
+
+/**
+ * @brief CPU implementation of ConvolutionLayer that never unrolls a whole
+ *        image. Falls back to ConvolutionLayer for GPU mode.
+ *
+ * The CAFFE engine im2col-transforms an entire image before multiplying it
+ * with the filters, so its column buffer is kernel_dim times the size of the
+ * output and for large inputs it no longer fits in cache (or memory). The
+ * DIRECT engine instead walks the output a tile of rows at a time, unrolling
+ * only the input patches of that tile into a buffer of at most
+ * column_tile_bytes, and multiplies each tile while it is still hot.
+ *
+ * 1x1 convolution with stride 1 and no padding needs no unrolling at all:
+ * the input already is the column matrix, so the filters are multiplied with
+ * it directly. Convolution over other than two spatial axes (or with
+ * force_nd_im2col) is handed to ConvolutionLayer.
+ */
+template <typename Dtype>
+class DirectConvolutionLayer : public ConvolutionLayer<Dtype> {
+ public:
+  explicit DirectConvolutionLayer(const LayerParameter& param)
+      : ConvolutionLayer<Dtype>(param) {}
+  virtual void Reshape(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+
+ protected:
+  virtual void Forward_cpu(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+  virtual void Backward_cpu(const vector<Blob<Dtype>*>& top,
+      const vector<bool>& propagate_down, const vector<Blob<Dtype>*>& bottom);
+
+  /// @brief Whether the tiled path applies, i.e. 2D convolution that is not
+  ///        1x1 with stride 1 and no padding.
+  bool use_tiles() const;
+  /// @brief Unroll the patches of output rows [row_begin, row_end) of input.
+  void im2col_tile(const Dtype* input, int row_begin, int row_end,
+      Dtype* col) const;
+  /// @brief Add the patches of output rows [row_begin, row_end) back into
+  ///        input_diff.
+  void col2im_tile(const Dtype* col, int row_begin, int row_end,
+      Dtype* input_diff) const;
+
+  /// @brief Borrow the buffers of one tile from the workspace: the
+  ///        (input channels x kernel size) x (tile_rows_ * output width)
+  ///        columns, followed by the output channels x (tile_rows_ * output
+  ///        width) products.
+  Dtype* tile_workspace();
+
+  /// @brief The number of output rows unrolled at a time.
+  int tile_rows_;
+};
+
+}  // namespace caffe
+
+#endif  // CAFFE_DIRECT_CONV_LAYER_HPP_
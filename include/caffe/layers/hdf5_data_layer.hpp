@@ -7,23 +7,39 @@
 #include <vector>
 
 #include "caffe/blob.hpp"
+#include "caffe/internal_thread.hpp"
 #include "caffe/layer.hpp"
 #include "caffe/proto/caffe.pb.h"
+#include "caffe/util/blocking_queue.hpp"
 
 #include "caffe/layers/base_data_layer.hpp"
 
 namespace caffe {
 
+/**
+ * @brief The rows of an HDF5DataLayer's datasets, one blob per top, that are
+ *        loaded together: the rows of a file, or of a range of a file.
+ */
+template <typename Dtype>
+class HDF5Chunk {
+ public:
+  vector<shared_ptr<Blob<Dtype> > > blobs_;
+};
+
 /**
  * @brief Provides data to the Net from HDF5 files.
  *
+ * The files are read in chunks of chunk_rows rows, or whole if chunk_rows is
+ * 0, and a thread loads the next chunk while Forward consumes the current
+ * one. Data that fits in a single chunk is loaded once, at setup.
+ *
  * TODO(dox): thorough documentation for Forward and proto params.
  */
 template <typename Dtype>
-class HDF5DataLayer : public Layer<Dtype> {
+class HDF5DataLayer : public Layer<Dtype>, public InternalThread {
  public:
   explicit HDF5DataLayer(const LayerParameter& param)
-      : Layer<Dtype>(param) {}
+      : Layer<Dtype>(param), current_chunk_(NULL) {}
   virtual ~HDF5DataLayer();
   virtual void LayerSetUp(const vector<Blob<Dtype>*>& bottom,
       const vector<Blob<Dtype>*>& top);
@@ -37,6 +53,9 @@ class HDF5DataLayer : public Layer<Dtype> {
   virtual inline int ExactNumBottomBlobs() const { return 0; }
   virtual inline int MinTopBlobs() const { return 1; }
 
+  // The chunks loaded concurrently: the current one and the next one.
+  static const int PREFETCH_COUNT = 2;
+
  protected:
   virtual void Forward_cpu(const vector<Blob<Dtype>*>& bottom,
       const vector<Blob<Dtype>*>& top);
@@ -46,15 +65,31 @@ class HDF5DataLayer : public Layer<Dtype> {
       const vector<bool>& propagate_down, const vector<Blob<Dtype>*>& bottom) {}
   virtual void Backward_gpu(const vector<Blob<Dtype>*>& top,
       const vector<bool>& propagate_down, const vector<Blob<Dtype>*>& bottom) {}
-  virtual void LoadHDF5FileData(const char* filename);
+  virtual void InternalThreadEntry();
+  // Loads up to chunk_rows_ rows of a file, starting at row begin, into
+  // chunk. Returns whether they reach the end of the file.
+  virtual bool LoadHDF5FileData(const char* filename, hsize_t begin,
+      HDF5Chunk<Dtype>* chunk);
+  // Loads the chunk after the last one loaded.
+  void LoadNextChunk(HDF5Chunk<Dtype>* chunk);
+  // Makes chunk the current one, shuffling its rows if need be.
+  void SetCurrentChunk(HDF5Chunk<Dtype>* chunk);
 
   std::vector<std::string> hdf_filenames_;
   unsigned int num_files_;
+  hsize_t chunk_rows_;
+  // The file, and the row in it, that the next chunk to load starts at.
   unsigned int current_file_;
+  hsize_t current_file_row_;
   hsize_t current_row_;
+  // The blobs of the current chunk.
   std::vector<shared_ptr<Blob<Dtype> > > hdf_blobs_;
   std::vector<unsigned int> data_permutation_;
   std::vector<unsigned int> file_permutation_;
+  HDF5Chunk<Dtype> prefetch_[PREFETCH_COUNT];
+  HDF5Chunk<Dtype>* current_chunk_;
+  BlockingQueue<HDF5Chunk<Dtype>*> prefetch_free_;
+  BlockingQueue<HDF5Chunk<Dtype>*> prefetch_full_;
 };
 
 }  // namespace caffe
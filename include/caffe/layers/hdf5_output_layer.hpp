@@ -7,8 +7,12 @@
 #include <vector>
 
 #include "caffe/blob.hpp"
+#include "caffe/internal_thread.hpp"
 #include "caffe/layer.hpp"
 #include "caffe/proto/caffe.pb.h"
+#include "caffe/util/blocking_queue.hpp"
+
+#include "caffe/layers/base_data_layer.hpp"
 
 namespace caffe {
 
@@ -18,10 +22,16 @@ namespace caffe {
 /**
  * @brief Write blobs to disk as HDF5 files.
  *
+ * Each Forward appends the rows of its bottoms to the "data" and "label"
+ * datasets, which are chunked and optionally compressed. Forward only copies
+ * the bottoms; a thread writes them, and Forward blocks only when queue_size
+ * batches are already waiting. All batches are written once the layer is
+ * destroyed.
+ *
  * TODO(dox): thorough documentation for Forward and proto params.
  */
 template <typename Dtype>
-class HDF5OutputLayer : public Layer<Dtype> {
+class HDF5OutputLayer : public Layer<Dtype>, public InternalThread {
  public:
   explicit HDF5OutputLayer(const LayerParameter& param)
       : Layer<Dtype>(param), file_opened_(false) {}
@@ -50,13 +60,17 @@ class HDF5OutputLayer : public Layer<Dtype> {
       const vector<bool>& propagate_down, const vector<Blob<Dtype>*>& bottom);
   virtual void Backward_gpu(const vector<Blob<Dtype>*>& top,
       const vector<bool>& propagate_down, const vector<Blob<Dtype>*>& bottom);
-  virtual void SaveBlobs();
+  virtual void InternalThreadEntry();
+  // Appends batch to the datasets. Called on the writer thread.
+  virtual void SaveBlobs(const Batch<Dtype>& batch);
 
   bool file_opened_;
   std::string file_name_;
   hid_t file_id_;
-  Blob<Dtype> data_blob_;
-  Blob<Dtype> label_blob_;
+  vector<shared_ptr<Batch<Dtype> > > batches_;
+  // Batches free to copy bottoms into, and batches waiting to be written.
+  BlockingQueue<Batch<Dtype>*> batch_free_;
+  BlockingQueue<Batch<Dtype>*> batch_full_;
 };
 
 }  // namespace caffe
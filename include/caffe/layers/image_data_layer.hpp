@@ -14,6 +14,8 @@
 
 namespace caffe {
 
+class ImageCache;
+
 /**
  * @brief Provides data to the Net from image files.
  *
@@ -23,7 +25,7 @@ template <typename Dtype>
 class ImageDataLayer : public BasePrefetchingDataLayer<Dtype> {
  public:
   explicit ImageDataLayer(const LayerParameter& param)
-      : BasePrefetchingDataLayer<Dtype>(param) {}
+      : BasePrefetchingDataLayer<Dtype>(param), cache_(NULL) {}
   virtual ~ImageDataLayer();
   virtual void DataLayerSetUp(const vector<Blob<Dtype>*>& bottom,
       const vector<Blob<Dtype>*>& top);
@@ -39,6 +41,8 @@ class ImageDataLayer : public BasePrefetchingDataLayer<Dtype> {
 
   vector<std::pair<std::string, int> > lines_;
   int lines_id_;
+  // The shared cache of decoded images, or NULL when not caching.
+  ImageCache* cache_;
 };
 
 
@@ -55,6 +55,14 @@ class LRNLayer : public Layer<Dtype> {
       const vector<bool>& propagate_down, const vector<Blob<Dtype>*>& bottom);
   virtual void WithinChannelBackward(const vector<Blob<Dtype>*>& top,
       const vector<bool>& propagate_down, const vector<Blob<Dtype>*>& bottom);
+  // The per-image part of the ACROSS_CHANNELS CPU passes for the images
+  // [image_begin, image_end), run across the CPU thread pool.
+  void CrossChannelForwardImages(const Dtype* bottom_data, Dtype* scale_data,
+      int image_begin, int image_end) const;
+  void CrossChannelBackwardImages(const Dtype* top_diff,
+      const Dtype* top_data, const Dtype* bottom_data,
+      const Dtype* scale_data, Dtype* bottom_diff, int image_begin,
+      int image_end) const;
 
   int size_;
   int pre_pad_;
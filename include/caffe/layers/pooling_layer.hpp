@@ -44,6 +44,27 @@ class PoolingLayer : public Layer<Dtype> {
   virtual void Backward_gpu(const vector<Blob<Dtype>*>& top,
       const vector<bool>& propagate_down, const vector<Blob<Dtype>*>& bottom);
 
+  // Pool (or unpool) the height_ x width_ planes [plane_begin, plane_end) of
+  // a batch. The planes are independent, so the CPU passes split them across
+  // the CPU thread pool. MaskType is int for max_idx_ and Dtype for a top
+  // mask.
+  template <typename MaskType>
+  void MaxPoolPlanes(const Dtype* bottom_data, Dtype* top_data,
+      MaskType* mask, int plane_begin, int plane_end) const;
+  void AvePoolPlanes(const Dtype* bottom_data, Dtype* top_data,
+      int plane_begin, int plane_end) const;
+  template <typename MaskType>
+  void MaxUnpoolPlanes(const Dtype* top_diff, const MaskType* mask,
+      Dtype* bottom_diff, int plane_begin, int plane_end) const;
+  void AveUnpoolPlanes(const Dtype* top_diff, Dtype* bottom_diff,
+      int plane_begin, int plane_end) const;
+  // Returns 2 or 3 if the pooling is a 2x2 or 3x3 stride 2 one with no
+  // padding, and 0 otherwise; full_h x full_w are the outputs whose windows
+  // lie entirely inside the plane and take the unrolled kernels.
+  int UnrolledKernelSize(int* full_h, int* full_w) const;
+  // The number of planes per parallel_for chunk, honoring num_threads.
+  int PlaneGrain(const int num_planes) const;
+
   int kernel_h_, kernel_w_;
   int stride_h_, stride_w_;
   int pad_h_, pad_w_;
@@ -51,6 +72,7 @@ class PoolingLayer : public Layer<Dtype> {
   int height_, width_;
   int pooled_height_, pooled_width_;
   bool global_pooling_;
+  int num_threads_;
   Blob<Dtype> rand_idx_;
   Blob<int> max_idx_;
 };
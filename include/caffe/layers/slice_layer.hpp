@@ -28,6 +28,10 @@ class SliceLayer : public Layer<Dtype> {
   virtual inline const char* type() const { return "Slice"; }
   virtual inline int ExactNumBottomBlobs() const { return 1; }
   virtual inline int MinTopBlobs() const { return 1; }
+  // A single top is the bottom passed through as is.
+  virtual inline bool SharesBottomData() const {
+    return this->layer_param_.top_size() == 1;
+  }
 
  protected:
   virtual void Forward_cpu(const vector<Blob<Dtype>*>& bottom,
@@ -0,0 +1,68 @@
+#ifndef CAFFE_WINOGRAD_CONV_LAYER_HPP_
+#define CAFFE_WINOGRAD_CONV_LAYER_HPP_
+
+#include <vector>
+
+#include "caffe/blob.hpp"
+#include "caffe/layer.hpp"
+#include "caffe/proto/caffe.pb.h"
+#include "caffe/syncedmem.hpp"
+
+#include "caffe/layers/conv_layer.hpp"
+
+namespace caffe {
+
+/**
+ * @brief CPU implementation of 3x3, stride 1 ConvolutionLayer by Winograd's
+ *        minimal filtering algorithm F(m x m, 3 x 3), m = 2 or 4.
+ *
+ * Each (m + 2) x (m + 2) input tile d and 3 x 3 filter g are transformed to
+ * V = B^T d B and U = G g G^T; the m x m output tile is A^T (U .* V) A
+ * (Lavin & Gray, "Fast Algorithms for Convolutional Neural Networks", 2015).
+ * Summed over input channels, the elementwise products become (m + 2)^2
+ * matrix multiplications of the transformed filters with the transformed
+ * tiles, which takes 2.25x (m = 2) or 4x (m = 4) fewer multiplies than
+ * im2col + GEMM.
+ *
+ * The transformed filters are cached and recomputed only once blobs_[0] has
+ * been written to. Backward, GPU mode, and layers with other kernels, strides
+ * or dilations are handled by ConvolutionLayer.
+ */
+template <typename Dtype>
+class WinogradConvolutionLayer : public ConvolutionLayer<Dtype> {
+ public:
+  explicit WinogradConvolutionLayer(const LayerParameter& param)
+      : ConvolutionLayer<Dtype>(param) {}
+  virtual void LayerSetUp(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+  virtual void Reshape(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+
+ protected:
+  virtual void Forward_cpu(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top);
+
+  /// @brief Recompute transformed_weights_ if blobs_[0] changed since.
+  void TransformWeights();
+  /// @brief Transform the tiles of one image into V, which is
+  ///        (m + 2)^2 x input channels x tiles.
+  void TransformInput(const Dtype* input, Dtype* V);
+  /// @brief Transform the products M = U V, (m + 2)^2 x output channels x
+  ///        tiles, back into the output of one image.
+  void TransformOutput(const Dtype* M, Dtype* output);
+
+  /// @brief Whether this layer is 3x3, stride 1, undilated 2D convolution.
+  bool use_winograd_;
+  /// @brief The output tile size m; input tiles are m + 2 on a side.
+  int tile_;
+  int tiles_h_, tiles_w_;
+  /// @brief U: (m + 2)^2 x output channels x input channels per group.
+  Blob<Dtype> transformed_weights_;
+  /// @brief The weights, and their version, transformed_weights_ holds.
+  shared_ptr<SyncedMemory> transformed_from_;
+  unsigned int transformed_version_;
+};
+
+}  // namespace caffe
+
+#endif  // CAFFE_WINOGRAD_CONV_LAYER_HPP_
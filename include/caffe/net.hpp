@@ -11,6 +11,7 @@
 #include "caffe/common.hpp"
 #include "caffe/layer.hpp"
 #include "caffe/proto/caffe.pb.h"
+#include "caffe/util/profiler.hpp"
 
 namespace caffe {
 
@@ -177,6 +178,20 @@ class Net {
   inline const vector<Blob<Dtype>*>& learnable_params() const {
     return learnable_params_;
   }
+  /**
+   * @brief The data and diffs of all learnable params back to back, in
+   *        learnable_params() order, with the params themselves views into
+   *        them (NetParameter.contiguous_params); NULL otherwise.
+   */
+  inline const shared_ptr<Blob<Dtype> >& flat_params() const {
+    return flat_params_;
+  }
+  /// @brief Move the data and diffs of the learnable params into
+  ///        flat_params(), as NetParameter.contiguous_params does in Init.
+  void FlattenParams();
+  /// @brief Mark the learnable params' data as changed, after it was written
+  ///        through flat_params() or another view of their memory.
+  void TouchParams();
   /// @brief returns the learnable parameter learning rate multipliers
   inline const vector<float>& params_lr() const { return params_lr_; }
   inline const vector<bool>& has_params_lr() const { return has_params_lr_; }
@@ -212,6 +227,11 @@ class Net {
   const shared_ptr<Layer<Dtype> > layer_by_name(const string& layer_name) const;
 
   void set_debug_info(const bool value) { debug_info_ = value; }
+  /// @brief Starts (with empty totals) or stops timing each layer's Forward
+  ///        and Backward.
+  void set_profiling(const bool value);
+  /// @brief The per-layer times recorded since profiling started, or NULL.
+  Profiler* profiler() const { return profiler_.get(); }
 
   // Helpers for Init.
   /**
@@ -237,6 +257,19 @@ class Net {
   /// @brief Append a new parameter blob to the net.
   void AppendParam(const NetParameter& param, const int layer_id,
                    const int param_id);
+  /**
+   * @brief Let the top blobs whose lifetimes do not overlap share their data
+   *        memory (NetParameter.share_activations).
+   *
+   * A blob lives from the layer that produces it to the last layer that
+   * takes it as bottom; blobs that SharesBottomData() layers tie together
+   * live as one. Net inputs and outputs, and the tops of bottomless (data)
+   * layers, keep their own memory.
+   */
+  void ShareActivationMemory();
+  /// @brief Plan the shared activation memory again if a Reshape grew a
+  ///        blob beyond its buffer, which gives the blob memory of its own.
+  void ReshareGrownActivations();
 
   /// @brief Helper for displaying debug info in Forward about input Blobs.
   void InputDebugInfo(const int layer_id);
@@ -246,6 +279,8 @@ class Net {
   void BackwardDebugInfo(const int layer_id);
   /// @brief Helper for displaying debug info in Update.
   void UpdateDebugInfo(const int param_id);
+  /// @brief Estimates the operations and bytes of one Forward of a layer.
+  void EstimateForwardCost(int layer_id, double* flops, double* bytes) const;
 
   /// @brief The network name
   string name_;
@@ -300,10 +335,15 @@ class Net {
   /// the weight decay multipliers for learnable_params_
   vector<float> params_weight_decay_;
   vector<bool> has_params_decay_;
+  /// The data and diffs of learnable_params_, if contiguous_params is set
+  shared_ptr<Blob<Dtype> > flat_params_;
+  /// The shared buffer each blob's data was given, if share_activations is set
+  vector<shared_ptr<SyncedMemory> > activation_buffers_;
   /// The bytes of memory used by this net
   size_t memory_used_;
   /// Whether to compute and display debug info for the net.
   bool debug_info_;
+  shared_ptr<Profiler> profiler_;
   /// The root net that actually holds the shared layers in data parallelism
   const Net* const root_net_;
   DISABLE_COPY_AND_ASSIGN(Net);
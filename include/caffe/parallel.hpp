@@ -14,6 +14,8 @@
 #include "caffe/syncedmem.hpp"
 #include "caffe/util/blocking_queue.hpp"
 
+namespace boost { class barrier; }
+
 namespace caffe {
 
 // Represents a net parameters. Once a net is created, its parameter buffers can
@@ -113,6 +115,44 @@ class P2PSync : public GPUParams<Dtype>, public Solver<Dtype>::Callback,
   using Params<Dtype>::diff_;
 };
 
+// Synchronous data parallelism between CPU threads, each running a solver
+// replica. The replicas compute with the root solver's flattened params, and
+// every iteration each thread sums its slice of all their flattened gradients
+// into the root's, after which the root alone applies the update. Set
+// Caffe::solver_count() to the number of workers before creating the root
+// solver, so that data layers split their input between the replicas.
+template<typename Dtype>
+class CPUSync : public Params<Dtype>, public Solver<Dtype>::Callback,
+    public InternalThread {
+ public:
+  explicit CPUSync(shared_ptr<Solver<Dtype> > root_solver,
+                   CPUSync<Dtype>* root = NULL);
+  virtual ~CPUSync();
+
+  inline const shared_ptr<Solver<Dtype> >& solver() const {
+    return solver_;
+  }
+
+  void run(int workers);
+
+ protected:
+  void on_start();
+  void on_gradients_ready();
+
+  void InternalThreadEntry();
+
+  CPUSync<Dtype>* root_;
+  vector<CPUSync<Dtype>*> syncs_;  // On the root, all of them in rank order
+  shared_ptr<boost::barrier> barrier_;
+  const int rank_;
+  const int initial_iter_;
+  shared_ptr<Solver<Dtype> > solver_;
+
+  using Params<Dtype>::size_;
+  using Params<Dtype>::data_;
+  using Params<Dtype>::diff_;
+};
+
 }  // namespace caffe
 
 #endif
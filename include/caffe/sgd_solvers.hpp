@@ -5,9 +5,33 @@
 #include <vector>
 
 #include "caffe/solver.hpp"
+#include "caffe/util/math_functions.hpp"
 
 namespace caffe {
 
+/**
+ * @brief The gradient of one element of a parameter as the CPU updates of
+ *        SGDSolver and its subclasses use it: the diff normalized over
+ *        iter_size plus the weight decay, which is what Normalize and
+ *        Regularize leave in the diff on the GPU.
+ *
+ * On the CPU each ComputeUpdateValue applies it within the same pass over the
+ * parameter as the update, rather than after separate passes.
+ */
+template <typename Dtype>
+struct SGDGradient {
+  Dtype scale;
+  Dtype decay;
+  bool l1;
+
+  inline Dtype operator()(const Dtype data, const Dtype diff) const {
+    return scale * diff + decay * (l1 ? Dtype(caffe_sign(data)) : data);
+  }
+};
+
+// Elements per parallel_for chunk of the CPU updates.
+const int kSGDUpdateGrain = 16384;
+
 /**
  * @brief Optimizes the parameters of a Net using
  *        stochastic gradient descent (SGD) with momentum.
@@ -29,6 +53,8 @@ class SGDSolver : public Solver<Dtype> {
   virtual void ApplyUpdate();
   virtual void Normalize(int param_id);
   virtual void Regularize(int param_id);
+  // The Normalize and Regularize terms, for a CPU ComputeUpdateValue.
+  SGDGradient<Dtype> CPUGradient(int param_id);
   virtual void ComputeUpdateValue(int param_id, Dtype rate);
   virtual void ClipGradients();
   virtual void SnapshotSolverState(const string& model_filename);
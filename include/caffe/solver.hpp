@@ -6,6 +6,7 @@
 
 #include "caffe/net.hpp"
 #include "caffe/solver_factory.hpp"
+#include "caffe/util/snapshot_writer.hpp"
 
 namespace caffe {
 
@@ -100,6 +101,10 @@ class Solver {
   string SnapshotFilename(const string extension);
   string SnapshotToBinaryProto();
   string SnapshotToHDF5();
+  // Writes a proto of the current snapshot, or with snapshot_async, queues
+  // it to be written once Snapshot has staged the whole snapshot.
+  void WriteProtoSnapshot(const shared_ptr<Message>& proto,
+      const string& filename);
   // The test routine
   void TestAll();
   void Test(const int test_net_id = 0);
@@ -126,6 +131,11 @@ class Solver {
   // True iff a request to stop early was received.
   bool requested_early_exit_;
 
+  // Writes the snapshots in the background when snapshot_async is set, and
+  // the files of the snapshot being taken, until it is handed over.
+  shared_ptr<SnapshotWriter> snapshot_writer_;
+  vector<SnapshotWriter::File> snapshot_files_;
+
   DISABLE_COPY_AND_ASSIGN(Solver);
 };
 
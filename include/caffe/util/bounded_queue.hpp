@@ -0,0 +1,57 @@
+#ifndef CAFFE_UTIL_BOUNDED_QUEUE_HPP_
+#define CAFFE_UTIL_BOUNDED_QUEUE_HPP_
+
+#include "caffe/common.hpp"
+
+namespace caffe {
+
+/**
+ * @brief A fixed-capacity queue that producers and consumers on any number
+ *        of threads use without locks, for the free / full queues of the
+ *        prefetch paths, which never hold more items than they were given.
+ *
+ * The items sit in a ring of slots, each with a sequence number that tells
+ * whose turn it is, so push and pop only take a compare-and-swap on their
+ * own end of the ring. Only when the ring is full (push) or empty (pop,
+ * peek) do they fall back to sleeping on a condition variable, which is a
+ * boost interruption point like in BlockingQueue.
+ */
+template<typename T>
+class BoundedQueue {
+ public:
+  // The capacity is rounded up to a power of two, and to at least two.
+  explicit BoundedQueue(int capacity);
+
+  // Waits while the queue is full.
+  void push(const T& t);
+  bool try_push(const T& t);
+
+  // Waits while the queue is empty, logging log_on_wait if given, which is
+  // useful for detecting e.g. when data feeding is too slow.
+  T pop(const char* log_on_wait = NULL);
+  bool try_pop(T* t);
+
+  // Return element without removing it. Only safe on the single consumer.
+  T peek();
+  bool try_peek(T* t);
+
+  // The items ready to pop, which other threads may change at any time.
+  size_t size() const;
+  size_t capacity() const;
+
+ protected:
+  /**
+   Move the ring and synchronization fields out instead of including boost
+   atomic and thread headers, to avoid the boost/NVCC issues BlockingQueue
+   works around.
+   */
+  class ring;
+
+  shared_ptr<ring> ring_;
+
+DISABLE_COPY_AND_ASSIGN(BoundedQueue);
+};
+
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_BOUNDED_QUEUE_HPP_
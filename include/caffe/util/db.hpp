@@ -15,9 +15,19 @@ class Cursor {
   Cursor() { }
   virtual ~Cursor() { }
   virtual void SeekToFirst() = 0;
+  // Moves to key, or to the first key after it if it is not in the database.
+  virtual void Seek(const string& key) = 0;
   virtual void Next() = 0;
   virtual string key() = 0;
   virtual string value() = 0;
+  // The value in place, without copying it out of the database; it stays
+  // valid until the cursor moves.
+  virtual const char* value_data() = 0;
+  virtual size_t value_size() = 0;
+  // Reads the value, a serialized Datum, into datum.
+  virtual void ParseDatum(Datum* datum) {
+    CHECK(datum->ParseFromArray(value_data(), value_size()));
+  }
   virtual bool valid() = 0;
 
   DISABLE_COPY_AND_ASSIGN(Cursor);
@@ -17,9 +17,12 @@ class LevelDBCursor : public Cursor {
     : iter_(iter) { SeekToFirst(); }
   ~LevelDBCursor() { delete iter_; }
   virtual void SeekToFirst() { iter_->SeekToFirst(); }
+  virtual void Seek(const string& key) { iter_->Seek(key); }
   virtual void Next() { iter_->Next(); }
   virtual string key() { return iter_->key().ToString(); }
   virtual string value() { return iter_->value().ToString(); }
+  virtual const char* value_data() { return iter_->value().data(); }
+  virtual size_t value_size() { return iter_->value().size(); }
   virtual bool valid() { return iter_->Valid(); }
 
  private:
@@ -0,0 +1,101 @@
+#ifndef CAFFE_UTIL_DB_RECORD_HPP
+#define CAFFE_UTIL_DB_RECORD_HPP
+
+#include <stdint.h>
+
+#include <fstream>  // NOLINT(readability/streams)
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "caffe/util/db.hpp"
+
+namespace caffe { namespace db {
+
+/**
+ * @brief A flat file of Datums that is memory-mapped for reading, so that
+ *        reading a record needs no protobuf parsing.
+ *
+ * The file is a header, the records, and an index of record offsets sorted
+ * by key, which is the order cursors visit the records in. A record is a
+ * fixed header with the Datum's shape, label and payload kind, followed by
+ * its key and its payload: the raw or encoded bytes of data, or the values
+ * of float_data. Numbers are stored in the byte order of the machine that
+ * wrote the file. Files are written once (NEW) and then only read (READ).
+ */
+class RecordCursor : public Cursor {
+ public:
+  RecordCursor(const char* file, const uint64_t* index, size_t num_records)
+    : file_(file), index_(index), num_records_(num_records), position_(0),
+      value_position_(num_records) { }
+  virtual void SeekToFirst() { position_ = 0; }
+  virtual void Seek(const string& key);
+  virtual void Next() { ++position_; }
+  virtual string key();
+  virtual string value();
+  // Records hold no serialized Datum, so these serialize one on demand;
+  // ParseDatum is the fast way to read a record.
+  virtual const char* value_data();
+  virtual size_t value_size();
+  virtual void ParseDatum(Datum* datum);
+  virtual bool valid() { return position_ < num_records_; }
+
+ private:
+  const char* record(size_t position) const {
+    return file_ + index_[position];
+  }
+
+  const char* file_;
+  const uint64_t* index_;
+  size_t num_records_;
+  size_t position_;
+  // The Datum of the record at value_position_, serialized for value_data.
+  string value_;
+  size_t value_position_;
+};
+
+class RecordDB;
+
+class RecordTransaction : public Transaction {
+ public:
+  explicit RecordTransaction(RecordDB* db) : db_(db) { }
+  virtual void Put(const string& key, const string& value);
+  virtual void Commit();
+
+ private:
+  RecordDB* db_;
+  vector<pair<string, string> > records_;
+
+  DISABLE_COPY_AND_ASSIGN(RecordTransaction);
+};
+
+class RecordDB : public DB {
+ public:
+  RecordDB()
+    : map_(NULL), map_size_(0), index_(NULL), num_records_(0), offset_(0) { }
+  virtual ~RecordDB() { Close(); }
+  virtual void Open(const string& source, Mode mode);
+  virtual void Close();
+  virtual RecordCursor* NewCursor();
+  virtual RecordTransaction* NewTransaction();
+
+  // Appends the record of a serialized Datum to a file opened with NEW.
+  void Append(const string& key, const string& value);
+
+ private:
+  // The mapped file, when reading.
+  char* map_;
+  size_t map_size_;
+  const uint64_t* index_;
+  size_t num_records_;
+  // The file, its size, and the keys and offsets of its records so far,
+  // when writing.
+  std::ofstream file_;
+  uint64_t offset_;
+  vector<pair<string, uint64_t> > offsets_;
+};
+
+}  // namespace db
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_DB_RECORD_HPP
@@ -0,0 +1,19 @@
+#ifndef CAFFE_UTIL_FOLD_BATCH_NORM_HPP_
+#define CAFFE_UTIL_FOLD_BATCH_NORM_HPP_
+
+#include "caffe/proto/caffe.pb.h"
+
+namespace caffe {
+
+// Copy an inference NetParameter whose layers carry their trained blobs,
+// folding each BatchNorm layer (using global statistics) that directly
+// follows a Convolution or InnerProduct layer into that layer's weights and
+// bias, and each ReLU (without negative slope) that follows a Convolution
+// layer into its fused_relu option. A layer is only folded into its
+// predecessor if no other layer reads the intermediate result; folding a
+// layer that is not in-place renames the predecessor's top to its own.
+void FoldBatchNorm(const NetParameter& param, NetParameter* param_folded);
+
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_FOLD_BATCH_NORM_HPP_
@@ -20,11 +20,29 @@ void hdf5_load_nd_dataset(
     hid_t file_id, const char* dataset_name_, int min_dim, int max_dim,
     Blob<Dtype>* blob);
 
+// Loads count rows of a dataset, starting at row begin of its first axis.
+template <typename Dtype>
+void hdf5_load_nd_dataset_rows(
+    hid_t file_id, const char* dataset_name_, hsize_t begin, hsize_t count,
+    int min_dim, int max_dim, Blob<Dtype>* blob);
+
+// The number of rows, the size of the first axis, of a dataset.
+hsize_t hdf5_get_num_rows(hid_t file_id, const char* dataset_name_);
+
 template <typename Dtype>
 void hdf5_save_nd_dataset(
     const hid_t file_id, const string& dataset_name, const Blob<Dtype>& blob,
     bool write_diff = false);
 
+// Appends the rows of blob to a dataset whose first axis can grow, creating
+// it if need be. New datasets are stored in chunks of chunk_rows rows, or of
+// the rows of blob if chunk_rows is 0, compressed with gzip at
+// compression_level if it is not 0.
+template <typename Dtype>
+void hdf5_append_nd_dataset(
+    hid_t file_id, const string& dataset_name, const Blob<Dtype>& blob,
+    hsize_t chunk_rows = 0, int compression_level = 0);
+
 int hdf5_load_int(hid_t loc_id, const string& dataset_name);
 void hdf5_save_int(hid_t loc_id, const string& dataset_name, int i);
 string hdf5_load_string(hid_t loc_id, const string& dataset_name);
@@ -34,6 +52,23 @@ void hdf5_save_string(hid_t loc_id, const string& dataset_name,
 int hdf5_get_num_links(hid_t loc_id);
 string hdf5_get_name_by_idx(hid_t loc_id, int idx);
 
+/**
+ * @brief Serializes the use of the HDF5 library, which is usually built
+ *        without thread safety, between threads.
+ *
+ * Code that may run while another thread uses HDF5, such as the prefetch
+ * thread of HDF5DataLayer, holds an HDF5Lock for the duration of its HDF5
+ * calls. The lock is recursive.
+ */
+class HDF5Lock {
+ public:
+  HDF5Lock();
+  ~HDF5Lock();
+
+ private:
+  DISABLE_COPY_AND_ASSIGN(HDF5Lock);
+};
+
 }  // namespace caffe
 
 #endif   // CAFFE_UTIL_HDF5_H_
@@ -0,0 +1,56 @@
+#ifndef CAFFE_UTIL_HOST_ALLOCATOR_HPP_
+#define CAFFE_UTIL_HOST_ALLOCATOR_HPP_
+
+#include <cstddef>
+
+#include "caffe/common.hpp"
+
+namespace caffe {
+
+/**
+ * @brief The caching allocator behind CaffeMallocHost for pageable memory.
+ *
+ * Requests are rounded up to a size class (four per power of two, so at most
+ * a quarter is wasted) and served 64-byte aligned. Freed blocks are kept in a
+ * free list per class instead of being returned to the system, so nets that
+ * keep reshaping blobs, e.g. serving inputs of varying size, reuse the same
+ * pages rather than faulting in new ones. The cache never holds more than the
+ * peak of memory in use; ReleaseCached gives it back.
+ *
+ * The allocator is shared by all threads of the process.
+ */
+class HostAllocator {
+ public:
+  struct Stats {
+    /// Bytes handed out and not yet freed, counted by size class.
+    size_t bytes_in_use;
+    /// Bytes held in the free lists.
+    size_t bytes_cached;
+    /// Allocations served from (hits) or not from (misses) the free lists.
+    size_t hits;
+    size_t misses;
+
+    double hit_rate() const {
+      return hits + misses ? static_cast<double>(hits) / (hits + misses) : 0;
+    }
+  };
+
+  static const size_t kAlignment = 64;
+
+  /// Returns kAlignment aligned memory of at least size bytes.
+  static void* Allocate(size_t size);
+  /// Takes back ptr, which Allocate(size) returned, into the cache.
+  static void Free(void* ptr, size_t size);
+  /// Returns all cached blocks to the system.
+  static void ReleaseCached();
+  static Stats stats();
+  /// The number of bytes Allocate(size) actually reserves.
+  static size_t SizeClass(size_t size);
+
+ private:
+  HostAllocator();
+};
+
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_HOST_ALLOCATOR_HPP_
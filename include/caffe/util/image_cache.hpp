@@ -0,0 +1,78 @@
+#ifndef CAFFE_UTIL_IMAGE_CACHE_HPP_
+#define CAFFE_UTIL_IMAGE_CACHE_HPP_
+
+#ifdef USE_OPENCV
+#include <opencv2/core/core.hpp>
+
+#include <list>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "caffe/common.hpp"
+
+namespace boost { class mutex; }
+
+namespace caffe {
+
+/**
+ * @brief Decoded images kept in memory up to a byte budget, so that reading
+ *        an image again skips the disk and the decoder.
+ *
+ * The least recently used images are evicted first; an image larger than
+ * the whole budget is not kept. Images are shared, not copied, with the
+ * callers of Lookup, so they must not be modified. All methods may be called
+ * from several threads.
+ *
+ * The process-wide instance, Get(), is shared by the ImageData layers that
+ * set cache_size_mb; its budget is the largest of theirs.
+ */
+class ImageCache {
+ public:
+  explicit ImageCache(size_t capacity);
+
+  static ImageCache& Get();
+
+  /// Copies the image cached under key to image, if there is one.
+  bool Lookup(const string& key, cv::Mat* image);
+  /// Caches image under key, evicting older images to make room for it.
+  void Insert(const string& key, const cv::Mat& image);
+  /// Raises the budget to capacity bytes, if it is lower.
+  void Reserve(size_t capacity);
+  void Clear();
+
+  size_t capacity() const;
+  /// The bytes of the cached images.
+  size_t size() const;
+  size_t hits() const;
+  size_t misses() const;
+
+ private:
+  void Evict(size_t capacity);
+
+  typedef std::list<string> Recency;
+  typedef std::map<string, std::pair<cv::Mat, Recency::iterator> > Images;
+
+  size_t capacity_;
+  size_t size_;
+  size_t hits_;
+  size_t misses_;
+  // The keys of images_, the most recently used first.
+  Recency recency_;
+  Images images_;
+  shared_ptr<boost::mutex> mutex_;
+
+  DISABLE_COPY_AND_ASSIGN(ImageCache);
+};
+
+/**
+ * @brief ReadImageToCVMat through cache, which may be NULL. The image is
+ *        cached under its filename and the size and color it is read with.
+ */
+cv::Mat ReadImageToCVMat(const string& filename, const int height,
+    const int width, const bool is_color, ImageCache* cache);
+
+}  // namespace caffe
+
+#endif  // USE_OPENCV
+#endif  // CAFFE_UTIL_IMAGE_CACHE_HPP_
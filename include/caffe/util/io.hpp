@@ -90,6 +90,14 @@ inline void WriteProtoToBinaryFile(
   WriteProtoToBinaryFile(proto, filename.c_str());
 }
 
+/**
+ * @brief Writes proto to filename so that a crash never leaves a partial
+ *        file: it is written to filename.tmp, synced, and renamed over
+ *        filename.
+ */
+void WriteProtoToBinaryFileAtomic(const Message& proto,
+    const string& filename);
+
 bool ReadFileToDatum(const string& filename, const int label, Datum* datum);
 
 inline bool ReadFileToDatum(const string& filename, Datum* datum) {
@@ -0,0 +1,76 @@
+#ifndef CAFFE_UTIL_PROFILER_HPP_
+#define CAFFE_UTIL_PROFILER_HPP_
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include <string>
+#include <vector>
+
+#include "caffe/common.hpp"
+#include "caffe/util/benchmark.hpp"
+
+namespace caffe {
+
+/**
+ * @brief Records how long each layer of a Net spends in Forward and
+ *        Backward, along with estimates of the work it does.
+ *
+ * Net calls LayerBegin / LayerEnd around every layer once profiling is on
+ * (Net::set_profiling). The totals per layer are kept until Reset, as is a
+ * timeline of the calls that WriteChromeTrace exports in the Trace Event
+ * format read by chrome://tracing. Timing uses Timer, so in GPU mode each
+ * layer is synchronized with the device.
+ */
+class Profiler {
+ public:
+  struct LayerStats {
+    string name;
+    string type;
+    int forward_calls;
+    int backward_calls;
+    double forward_us;
+    double backward_us;
+    /// Estimated floating point operations and bytes of blob data touched
+    /// by the recorded Forward calls.
+    double forward_flops;
+    double forward_bytes;
+  };
+
+  Profiler(const vector<string>& layer_names,
+      const vector<string>& layer_types);
+
+  void LayerBegin();
+  /// Ends the call LayerBegin started; flops and bytes are its estimates.
+  void LayerEnd(int layer, bool forward, double flops, double bytes);
+  /// Clears the totals and the timeline.
+  void Reset();
+
+  const vector<LayerStats>& layer_stats() const { return layer_stats_; }
+  /// A table of the per-layer totals, most expensive layers first.
+  string Summary() const;
+  void WriteChromeTrace(const string& filename) const;
+
+  /// The timeline keeps at most this many calls; later ones only count
+  /// towards the totals.
+  static const int kMaxEvents = 1 << 20;
+
+ private:
+  struct Event {
+    int layer;
+    bool forward;
+    double begin_us;
+    double duration_us;
+  };
+
+  vector<LayerStats> layer_stats_;
+  vector<Event> events_;
+  Timer timer_;
+  boost::posix_time::ptime epoch_;
+  double begin_us_;
+
+  DISABLE_COPY_AND_ASSIGN(Profiler);
+};
+
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_PROFILER_HPP_
@@ -0,0 +1,49 @@
+#ifndef CAFFE_UTIL_SNAPSHOT_WRITER_HPP_
+#define CAFFE_UTIL_SNAPSHOT_WRITER_HPP_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "google/protobuf/message.h"
+
+#include "caffe/common.hpp"
+
+namespace caffe {
+
+using ::google::protobuf::Message;
+
+/**
+ * @brief Writes the snapshots of a Solver on a background thread.
+ *
+ * A snapshot is a list of protos, already copied out of the net and solver,
+ * and the files to write them to. Write queues it and returns at once, unless
+ * max_pending snapshots are still being written. Files are written in order,
+ * so a solver state never reaches disk before the net it refers to, and each
+ * goes through WriteProtoToBinaryFileAtomic.
+ */
+class SnapshotWriter {
+ public:
+  typedef std::pair<shared_ptr<Message>, string> File;
+
+  explicit SnapshotWriter(int max_pending);
+  /// Waits for the queued snapshots to be written.
+  ~SnapshotWriter();
+
+  /// Queues a snapshot, first waiting while max_pending are in flight.
+  void Write(const vector<File>& files);
+  /// Blocks until every snapshot queued so far is written.
+  void Flush();
+  /// The snapshots queued or being written.
+  int pending() const;
+
+ private:
+  class Impl;
+  shared_ptr<Impl> impl_;
+
+  DISABLE_COPY_AND_ASSIGN(SnapshotWriter);
+};
+
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_SNAPSHOT_WRITER_HPP_
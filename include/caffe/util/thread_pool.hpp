@@ -0,0 +1,62 @@
+#ifndef CAFFE_UTIL_THREAD_POOL_HPP_
+#define CAFFE_UTIL_THREAD_POOL_HPP_
+
+#include <boost/function.hpp>
+
+#include "caffe/common.hpp"
+
+namespace caffe {
+
+/**
+ * @brief A fixed set of worker threads that CPU code splits loops across.
+ *
+ * A range handed to Run is cut into one contiguous block per participant:
+ * the workers plus the calling thread, which works rather than waits. Each
+ * participant takes grain-sized chunks from the front of its own block and,
+ * once that runs dry, steals chunks from the back of the others, so uneven
+ * chunk costs balance out without a shared queue.
+ *
+ * Run is not reentrant: a Run issued from inside a body, or while another
+ * thread is running the pool, executes serially on the calling thread.
+ * Bodies run on pool threads whose thread local Caffe state is the default
+ * one, so they should not depend on Caffe::mode() or draw random numbers.
+ *
+ * The process-wide instance is Caffe::thread_pool(); use parallel_for.
+ */
+class ThreadPool {
+ public:
+  /// Processes the iterations [begin, end) of a range.
+  typedef boost::function<void(int, int)> Body;
+
+  /// Starts num_threads - 1 workers (the caller is the remaining thread).
+  explicit ThreadPool(int num_threads);
+  ~ThreadPool();
+
+  /// The number of threads a range is split across, including the caller.
+  int num_threads() const;
+  /// Joins the current workers and starts new ones; not safe during a Run.
+  void Resize(int num_threads);
+  /// Calls body on disjoint chunks of up to grain iterations covering
+  /// [begin, end) and returns once all of them are done.
+  void Run(int begin, int end, int grain, const Body& body);
+
+ private:
+  class Impl;
+  shared_ptr<Impl> impl_;
+
+  DISABLE_COPY_AND_ASSIGN(ThreadPool);
+};
+
+/**
+ * @brief Runs body over [begin, end) on Caffe::thread_pool().
+ *
+ * body(b, e) is called on disjoint sub-ranges; pick grain so that a chunk
+ * amortizes the cost of handing it to another thread (tens of microseconds
+ * of work). With Caffe::cpu_threads() == 1 this is just body(begin, end).
+ */
+void parallel_for(const int begin, const int end,
+    const ThreadPool::Body& body, const int grain = 1);
+
+}  // namespace caffe
+
+#endif  // CAFFE_UTIL_THREAD_POOL_HPP_
@@ -5,7 +5,9 @@
 #include <ctime>
 
 #include "caffe/common.hpp"
+#include "caffe/syncedmem.hpp"
 #include "caffe/util/rng.hpp"
+#include "caffe/util/thread_pool.hpp"
 
 namespace caffe {
 
@@ -19,6 +21,51 @@ Caffe& Caffe::Get() {
   return *(thread_instance_.get());
 }
 
+// The CPU thread pool is shared by the whole process.
+static boost::mutex thread_pool_mutex_;
+static shared_ptr<ThreadPool> thread_pool_;
+
+ThreadPool& Caffe::thread_pool() {
+  boost::mutex::scoped_lock lock(thread_pool_mutex_);
+  if (!thread_pool_) {
+    thread_pool_.reset(new ThreadPool(1));
+  }
+  return *thread_pool_;
+}
+
+int Caffe::cpu_threads() {
+  return thread_pool().num_threads();
+}
+
+void Caffe::set_cpu_threads(int threads) {
+  thread_pool().Resize(threads);
+}
+
+static SyncedMemory* GrowWorkspace(shared_ptr<SyncedMemory>* workspace,
+    size_t size) {
+  if (!*workspace || (*workspace)->size() < size) {
+    // Free the old buffer before allocating its replacement.
+    workspace->reset();
+    workspace->reset(new SyncedMemory(size));
+  }
+  return workspace->get();
+}
+
+SyncedMemory* Caffe::cpu_workspace(size_t size) {
+  return GrowWorkspace(&Get().cpu_workspace_, size);
+}
+
+#ifndef CPU_ONLY
+SyncedMemory* Caffe::gpu_workspace(size_t size) {
+  return GrowWorkspace(&Get().gpu_workspace_, size);
+}
+#endif
+
+void Caffe::release_workspace() {
+  Get().cpu_workspace_.reset();
+  Get().gpu_workspace_.reset();
+}
+
 // random seeding
 int64_t cluster_seedgen(void) {
   int64_t s, seed, pid;
@@ -1,4 +1,5 @@
 #include <boost/thread.hpp>
+#include <algorithm>
 #include <map>
 #include <string>
 #include <vector>
@@ -7,6 +8,7 @@
 #include "caffe/data_reader.hpp"
 #include "caffe/layers/data_layer.hpp"
 #include "caffe/proto/caffe.pb.h"
+#include "caffe/util/rng.hpp"
 
 namespace caffe {
 
@@ -15,9 +17,11 @@ using boost::weak_ptr;
 map<const string, weak_ptr<DataReader::Body> > DataReader::bodies_;
 static boost::mutex bodies_mutex_;
 
+// The queue holds enough datums for the batches the layer may grow to, so
+// the reader keeps up with the extra prefetching.
 DataReader::DataReader(const LayerParameter& param)
-    : queue_pair_(new QueuePair(  //
-        param.data_param().prefetch() * param.data_param().batch_size())) {
+    : queue_pair_(new QueuePair(std::max(param.data_param().prefetch(),
+        param.data_param().max_prefetch()) * param.data_param().batch_size())) {
   // Get or create a body
   boost::mutex::scoped_lock lock(bodies_mutex_);
   string key = source_key(param);
@@ -41,7 +45,8 @@ DataReader::~DataReader() {
 
 //
 
-DataReader::QueuePair::QueuePair(int size) {
+DataReader::QueuePair::QueuePair(int size)
+    : free_(std::max(1, size)), full_(std::max(1, size)) {
   // Initialize the free queue with requested number of datums
   for (int i = 0; i < size; ++i) {
     free_.push(new Datum());
@@ -60,9 +65,82 @@ DataReader::QueuePair::~QueuePair() {
 
 //
 
+DataReader::Shard::Shard(db::Cursor* cursor, const vector<string>& block_keys,
+    int block_size, int size, const DataParameter& param)
+    : free_(std::max<int>(1, param.batch_size())),
+      full_(std::max<int>(1, param.batch_size())), cursor_(cursor),
+      block_keys_(block_keys), block_size_(block_size), size_(size),
+      param_(param) {
+  for (int i = 0; i < std::max<int>(1, param_.batch_size()); ++i) {
+    free_.push(new Datum());
+  }
+  StartInternalThread();
+}
+
+DataReader::Shard::~Shard() {
+  StopInternalThread();
+  Datum* datum;
+  while (free_.try_pop(&datum)) {
+    delete datum;
+  }
+  while (full_.try_pop(&datum)) {
+    delete datum;
+  }
+}
+
+void DataReader::Shard::InternalThreadEntry() {
+  const int num_blocks = block_keys_.size();
+  vector<int> order(num_blocks);
+  for (int i = 0; i < num_blocks; ++i) {
+    order[i] = i;
+  }
+  const int buffer_size =
+      param_.shuffle() ? param_.shuffle_buffer_size() : 0;
+  vector<shared_ptr<Datum> > buffer;
+  try {
+    while (!must_stop()) {
+      if (param_.shuffle()) {
+        shuffle(order.begin(), order.end());
+      }
+      for (int k = 0; k < num_blocks && !must_stop(); ++k) {
+        const int block = order[k];
+        // Blocks that follow each other in the database need no seek.
+        if (k == 0 || block != order[k - 1] + 1) {
+          cursor_->Seek(block_keys_[block]);
+        }
+        const int end = std::min(size_, (block + 1) * block_size_);
+        for (int i = block * block_size_; i < end; ++i) {
+          CHECK(cursor_->valid());
+          if (buffer.size() < buffer_size) {
+            buffer.push_back(shared_ptr<Datum>(new Datum()));
+            cursor_->ParseDatum(buffer.back().get());
+          } else {
+            Datum* datum = free_.pop();
+            if (buffer_size > 0) {
+              // Send a random buffered record and buffer this one instead.
+              Datum* buffered = buffer[caffe_rng_rand() % buffer_size].get();
+              datum->Swap(buffered);
+              cursor_->ParseDatum(buffered);
+            } else {
+              cursor_->ParseDatum(datum);
+            }
+            full_.push(datum);
+          }
+          cursor_->Next();
+        }
+      }
+    }
+  } catch (boost::thread_interrupted&) {
+    // Interrupted exception is expected on shutdown
+  }
+}
+
+//
+
 DataReader::Body::Body(const LayerParameter& param)
     : param_(param),
-      new_queue_pairs_() {
+      new_queue_pairs_(),
+      next_shard_(0) {
   StartInternalThread();
 }
 
@@ -75,6 +153,11 @@ void DataReader::Body::InternalThreadEntry() {
   db->Open(param_.data_param().source(), db::READ);
   shared_ptr<db::Cursor> cursor(db->NewCursor());
   vector<shared_ptr<QueuePair> > qps;
+  const int reader_threads = param_.data_param().reader_threads();
+  CHECK_GE(reader_threads, 1) << "A data source needs a reader thread.";
+  if (reader_threads > 1 || param_.data_param().shuffle()) {
+    StartShards(db.get(), reader_threads);
+  }
   try {
     int solver_count = param_.phase() == TRAIN ? Caffe::solver_count() : 1;
 
@@ -83,13 +166,21 @@ void DataReader::Body::InternalThreadEntry() {
     // so read one item, then wait for the next solver.
     for (int i = 0; i < solver_count; ++i) {
       shared_ptr<QueuePair> qp(new_queue_pairs_.pop());
-      read_one(cursor.get(), qp.get());
+      if (shards_.size()) {
+        read_one(shards_[next_shard_].get(), qp.get());
+      } else {
+        read_one(cursor.get(), qp.get());
+      }
       qps.push_back(qp);
     }
     // Main loop
     while (!must_stop()) {
       for (int i = 0; i < solver_count; ++i) {
-        read_one(cursor.get(), qps[i].get());
+        if (shards_.size()) {
+          read_one(shards_[next_shard_].get(), qps[i].get());
+        } else {
+          read_one(cursor.get(), qps[i].get());
+        }
       }
       // Check no additional readers have been created. This can happen if
       // more than one net is trained at a time per process, whether single
@@ -100,12 +191,73 @@ void DataReader::Body::InternalThreadEntry() {
   } catch (boost::thread_interrupted&) {
     // Interrupted exception is expected on shutdown
   }
+  // The shards' cursors must be closed before the database.
+  shards_.clear();
+}
+
+void DataReader::Body::StartShards(db::DB* db, int num_shards) {
+  const DataParameter& data_param = param_.data_param();
+  // Only the first key of each block is kept. Ranges are made of whole
+  // blocks, and shuffling permutes the blocks of a range.
+  const int block_size =
+      data_param.shuffle() ? data_param.shuffle_block_size() : 1;
+  CHECK_GE(block_size, 1) << "Shuffled blocks need at least one record.";
+  vector<string> block_keys;
+  int num_records = 0;
+  shared_ptr<db::Cursor> cursor(db->NewCursor());
+  for (cursor->SeekToFirst(); cursor->valid(); cursor->Next()) {
+    if (num_records++ % block_size == 0) {
+      block_keys.push_back(cursor->key());
+    }
+  }
+  CHECK_GT(num_records, 0) << "Data source " << data_param.source()
+      << " is empty.";
+  const int num_blocks = block_keys.size();
+  num_shards = std::min(num_shards, num_blocks);
+  for (int i = 0; i < num_shards; ++i) {
+    const int begin = int64_t(num_blocks) * i / num_shards;
+    const int end = int64_t(num_blocks) * (i + 1) / num_shards;
+    const int size =
+        std::min(end * block_size, num_records) - begin * block_size;
+    // Cursors are made here rather than on the shards' threads, as LMDB
+    // does not allow opening them concurrently.
+    shards_.push_back(shared_ptr<Shard>(new Shard(db->NewCursor(),
+        vector<string>(block_keys.begin() + begin,
+            block_keys.begin() + end), block_size, size, data_param)));
+    shard_remaining_.push_back(size);
+  }
+  LOG(INFO) << "Reading " << num_records << " records of "
+      << data_param.source() << " on " << num_shards << " threads"
+      << (data_param.shuffle() ? ", shuffled." : ".");
+}
+
+void DataReader::Body::read_one(Shard* shard, QueuePair* qp) {
+  Datum* datum = qp->free_.pop();
+  Datum* read = shard->full_.pop();
+  datum->Swap(read);
+  shard->free_.push(read);
+  qp->full_.push(datum);
+  // The shards take turns, skipping those done with the current epoch, so
+  // every record is read once per epoch however the shards differ in size.
+  --shard_remaining_[next_shard_];
+  for (int i = 1; i <= shards_.size(); ++i) {
+    const int shard_id = (next_shard_ + i) % shards_.size();
+    if (shard_remaining_[shard_id] > 0) {
+      next_shard_ = shard_id;
+      return;
+    }
+  }
+  for (int i = 0; i < shards_.size(); ++i) {
+    shard_remaining_[i] = shards_[i]->size();
+  }
+  next_shard_ = 0;
 }
 
 void DataReader::Body::read_one(db::Cursor* cursor, QueuePair* qp) {
   Datum* datum = qp->free_.pop();
-  // TODO deserialize in-place instead of copy?
-  datum->ParseFromString(cursor->value());
+  // Parse straight from the database's memory; the datums are recycled, so
+  // this copies the payload into a buffer that is already allocated.
+  cursor->ParseDatum(datum);
   qp->full_.push(datum);
 
   // go to the next iter
@@ -1,6 +1,10 @@
 #ifdef USE_OPENCV
 #include <opencv2/core/core.hpp>
 #endif  // USE_OPENCV
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif  // __SSE2__
+#include <stdint.h>
 
 #include <string>
 #include <vector>
@@ -38,6 +42,57 @@ DataTransformer<Dtype>::DataTransformer(const TransformationParameter& param,
   }
 }
 
+// Transforms a row of n uint8 pixels: y = (x - mean) * scale, where mean is
+// the row of the mean file or, when that is NULL, mean_value. With mirror
+// the row is written to y in reverse.
+template <typename Dtype>
+static void TransformRow(const int n, const uint8_t* x, const Dtype* mean,
+    const Dtype mean_value, const Dtype scale, const bool mirror, Dtype* y) {
+  for (int i = 0; i < n; ++i) {
+    const Dtype value =
+        (static_cast<Dtype>(x[i]) - (mean ? mean[i] : mean_value)) * scale;
+    y[mirror ? n - 1 - i : i] = value;
+  }
+}
+
+// The float version converts and transforms 16 pixels at a time.
+static void TransformRow(const int n, const uint8_t* x, const float* mean,
+    const float mean_value, const float scale, const bool mirror, float* y) {
+  int i = 0;
+#ifdef __SSE2__
+  const __m128i zero = _mm_setzero_si128();
+  const __m128 scale4 = _mm_set1_ps(scale);
+  const __m128 mean_value4 = _mm_set1_ps(mean_value);
+  for (; i + 16 <= n; i += 16) {
+    const __m128i bytes =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i));
+    const __m128i low = _mm_unpacklo_epi8(bytes, zero);
+    const __m128i high = _mm_unpackhi_epi8(bytes, zero);
+    __m128 values[4];
+    values[0] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero));
+    values[1] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero));
+    values[2] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero));
+    values[3] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero));
+    for (int k = 0; k < 4; ++k) {
+      const int j = i + 4 * k;
+      const __m128 mean4 = mean ? _mm_loadu_ps(mean + j) : mean_value4;
+      const __m128 value = _mm_mul_ps(_mm_sub_ps(values[k], mean4), scale4);
+      if (mirror) {
+        _mm_storeu_ps(y + n - 4 - j,
+            _mm_shuffle_ps(value, value, _MM_SHUFFLE(0, 1, 2, 3)));
+      } else {
+        _mm_storeu_ps(y + j, value);
+      }
+    }
+  }
+#endif  // __SSE2__
+  for (; i < n; ++i) {
+    const float value =
+        (static_cast<float>(x[i]) - (mean ? mean[i] : mean_value)) * scale;
+    y[mirror ? n - 1 - i : i] = value;
+  }
+}
+
 template<typename Dtype>
 void DataTransformer<Dtype>::Transform(const Datum& datum,
                                        Dtype* transformed_data) {
@@ -93,6 +148,22 @@ void DataTransformer<Dtype>::Transform(const Datum& datum,
     }
   }
 
+  if (has_uint8) {
+    // The crop, mirror, mean and scale are fused into one pass per row.
+    const uint8_t* datum_data = reinterpret_cast<const uint8_t*>(data.data());
+    for (int c = 0; c < datum_channels; ++c) {
+      const Dtype mean_value = has_mean_values ? mean_values_[c] : 0;
+      for (int h = 0; h < height; ++h) {
+        const int data_index =
+            (c * datum_height + h_off + h) * datum_width + w_off;
+        TransformRow(width, datum_data + data_index,
+            has_mean_file ? mean + data_index : NULL, mean_value, scale,
+            do_mirror, transformed_data + (c * height + h) * width);
+      }
+    }
+    return;
+  }
+
   Dtype datum_element;
   int top_index, data_index;
   for (int c = 0; c < datum_channels; ++c) {
@@ -104,12 +175,7 @@ void DataTransformer<Dtype>::Transform(const Datum& datum,
         } else {
           top_index = (c * height + h) * width + w;
         }
-        if (has_uint8) {
-          datum_element =
-            static_cast<Dtype>(static_cast<uint8_t>(data[data_index]));
-        } else {
-          datum_element = datum.float_data(data_index);
-        }
+        datum_element = datum.float_data(data_index);
         if (has_mean_file) {
           transformed_data[top_index] =
             (datum_element - mean[data_index]) * scale;
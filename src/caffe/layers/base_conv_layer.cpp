@@ -139,6 +139,9 @@ void BaseConvolutionLayer<Dtype>::LayerSetUp(const vector<Blob<Dtype>*>& bottom,
     weight_shape.push_back(kernel_shape_data[i]);
   }
   bias_term_ = this->layer_param_.convolution_param().bias_term();
+  fused_relu_ = this->layer_param_.convolution_param().fused_relu();
+  CHECK(!fused_relu_ || !reverse_dimensions())
+      << "Deconvolution does not support fused_relu.";
   vector<int> bias_shape(bias_term_, num_output_);
   if (this->blobs_.size() > 0) {
     CHECK_EQ(1 + bias_term_, this->blobs_.size())
@@ -228,7 +231,8 @@ void BaseConvolutionLayer<Dtype>::Reshape(const vector<Blob<Dtype>*>& bottom,
   }
   // The im2col result buffer will only hold one image at a time to avoid
   // overly large memory usage. In the special case of 1x1 convolution
-  // it goes lazily unused to save memory.
+  // it goes unused. Its memory is only borrowed from the thread's workspace
+  // while a gemm helper runs, so all layers of a net share one buffer.
   col_buffer_shape_.clear();
   col_buffer_shape_.push_back(kernel_dim_ * group_);
   for (int i = 0; i < num_spatial_axes_; ++i) {
@@ -241,6 +245,17 @@ void BaseConvolutionLayer<Dtype>::Reshape(const vector<Blob<Dtype>*>& bottom,
   col_buffer_.Reshape(col_buffer_shape_);
   bottom_dim_ = bottom[0]->count(channel_axis_);
   top_dim_ = top[0]->count(channel_axis_);
+  // Unroll several images at once if they fit in the workspace budget.
+  col_batch_ = 1;
+  const size_t workspace_bytes =
+      this->layer_param_.convolution_param().batch_workspace_bytes();
+  if (workspace_bytes > 0 && num_spatial_axes_ == 2 && !force_nd_im2col_ &&
+      !reverse_dimensions()) {
+    const size_t image_bytes = sizeof(Dtype) *
+        (kernel_dim_ * group_ + conv_out_channels_) * conv_out_spatial_dim_;
+    col_batch_ = std::max(1, std::min(num_,
+        static_cast<int>(workspace_bytes / image_bytes)));
+  }
   num_kernels_im2col_ = conv_in_channels_ * conv_out_spatial_dim_;
   num_kernels_col2im_ = reverse_dimensions() ? top_dim_ : bottom_dim_;
   // Set up the all ones "bias multiplier" for adding biases by BLAS
@@ -258,10 +273,12 @@ void BaseConvolutionLayer<Dtype>::forward_cpu_gemm(const Dtype* input,
     const Dtype* weights, Dtype* output, bool skip_im2col) {
   const Dtype* col_buff = input;
   if (!is_1x1_) {
+    // With skip_im2col this reuses the columns weight_cpu_gemm left behind.
+    Dtype* workspace = workspace_cpu(col_buffer_.count());
     if (!skip_im2col) {
-      conv_im2col_cpu(input, col_buffer_.mutable_cpu_data());
+      conv_im2col_cpu(input, workspace);
     }
-    col_buff = col_buffer_.cpu_data();
+    col_buff = workspace;
   }
   for (int g = 0; g < group_; ++g) {
     caffe_cpu_gemm<Dtype>(CblasNoTrans, CblasNoTrans, conv_out_channels_ /
@@ -282,9 +299,9 @@ void BaseConvolutionLayer<Dtype>::forward_cpu_bias(Dtype* output,
 template <typename Dtype>
 void BaseConvolutionLayer<Dtype>::backward_cpu_gemm(const Dtype* output,
     const Dtype* weights, Dtype* input) {
-  Dtype* col_buff = col_buffer_.mutable_cpu_data();
-  if (is_1x1_) {
-    col_buff = input;
+  Dtype* col_buff = input;
+  if (!is_1x1_) {
+    col_buff = workspace_cpu(col_buffer_.count());
   }
   for (int g = 0; g < group_; ++g) {
     caffe_cpu_gemm<Dtype>(CblasTrans, CblasNoTrans, kernel_dim_,
@@ -302,8 +319,9 @@ void BaseConvolutionLayer<Dtype>::weight_cpu_gemm(const Dtype* input,
     const Dtype* output, Dtype* weights) {
   const Dtype* col_buff = input;
   if (!is_1x1_) {
-    conv_im2col_cpu(input, col_buffer_.mutable_cpu_data());
-    col_buff = col_buffer_.cpu_data();
+    Dtype* workspace = workspace_cpu(col_buffer_.count());
+    conv_im2col_cpu(input, workspace);
+    col_buff = workspace;
   }
   for (int g = 0; g < group_; ++g) {
     caffe_cpu_gemm<Dtype>(CblasNoTrans, CblasTrans, conv_out_channels_ / group_,
@@ -320,6 +338,113 @@ void BaseConvolutionLayer<Dtype>::backward_cpu_bias(Dtype* bias,
       input, bias_multiplier_.cpu_data(), 1., bias);
 }
 
+template <typename Dtype>
+void BaseConvolutionLayer<Dtype>::gather_outputs(const Dtype* output,
+    int batch, Dtype* output_buff) {
+  const int col_stride = batch * conv_out_spatial_dim_;
+  for (int n = 0; n < batch; ++n) {
+    for (int c = 0; c < conv_out_channels_; ++c) {
+      caffe_copy(conv_out_spatial_dim_,
+          output + n * top_dim_ + c * conv_out_spatial_dim_,
+          output_buff + c * col_stride + n * conv_out_spatial_dim_);
+    }
+  }
+}
+
+template <typename Dtype>
+void BaseConvolutionLayer<Dtype>::scatter_outputs(const Dtype* output_buff,
+    int batch, Dtype* output) {
+  const int col_stride = batch * conv_out_spatial_dim_;
+  for (int n = 0; n < batch; ++n) {
+    for (int c = 0; c < conv_out_channels_; ++c) {
+      caffe_copy(conv_out_spatial_dim_,
+          output_buff + c * col_stride + n * conv_out_spatial_dim_,
+          output + n * top_dim_ + c * conv_out_spatial_dim_);
+    }
+  }
+}
+
+template <typename Dtype>
+Dtype* BaseConvolutionLayer<Dtype>::batch_workspace_cpu(int batch) {
+  return workspace_cpu((kernel_dim_ * group_ + conv_out_channels_) * batch *
+      conv_out_spatial_dim_);
+}
+
+template <typename Dtype>
+void BaseConvolutionLayer<Dtype>::forward_cpu_gemm_batch(const Dtype* input,
+    const Dtype* weights, Dtype* output, int batch) {
+  if (batch == 1) {
+    forward_cpu_gemm(input, weights, output);
+    return;
+  }
+  CHECK_LE(batch, col_batch_);
+  const int col_stride = batch * conv_out_spatial_dim_;
+  Dtype* col_buff = batch_workspace_cpu(batch);
+  Dtype* output_buff = col_buff + kernel_dim_ * group_ * col_stride;
+  for (int n = 0; n < batch; ++n) {
+    conv_im2col_cpu(input + n * bottom_dim_, col_stride,
+        col_buff + n * conv_out_spatial_dim_);
+  }
+  for (int g = 0; g < group_; ++g) {
+    caffe_cpu_gemm<Dtype>(CblasNoTrans, CblasNoTrans, conv_out_channels_ /
+        group_, col_stride, kernel_dim_,
+        (Dtype)1., weights + weight_offset_ * g,
+        col_buff + kernel_dim_ * col_stride * g,
+        (Dtype)0., output_buff + conv_out_channels_ / group_ * col_stride * g);
+  }
+  scatter_outputs(output_buff, batch, output);
+}
+
+template <typename Dtype>
+void BaseConvolutionLayer<Dtype>::backward_cpu_gemm_batch(const Dtype* output,
+    const Dtype* weights, Dtype* input, int batch) {
+  if (batch == 1) {
+    backward_cpu_gemm(output, weights, input);
+    return;
+  }
+  CHECK_LE(batch, col_batch_);
+  const int col_stride = batch * conv_out_spatial_dim_;
+  Dtype* col_buff = batch_workspace_cpu(batch);
+  Dtype* output_buff = col_buff + kernel_dim_ * group_ * col_stride;
+  gather_outputs(output, batch, output_buff);
+  for (int g = 0; g < group_; ++g) {
+    caffe_cpu_gemm<Dtype>(CblasTrans, CblasNoTrans, kernel_dim_,
+        col_stride, conv_out_channels_ / group_,
+        (Dtype)1., weights + weight_offset_ * g,
+        output_buff + conv_out_channels_ / group_ * col_stride * g,
+        (Dtype)0., col_buff + kernel_dim_ * col_stride * g);
+  }
+  for (int n = 0; n < batch; ++n) {
+    conv_col2im_cpu(col_buff + n * conv_out_spatial_dim_, col_stride,
+        input + n * bottom_dim_);
+  }
+}
+
+template <typename Dtype>
+void BaseConvolutionLayer<Dtype>::weight_cpu_gemm_batch(const Dtype* input,
+    const Dtype* output, Dtype* weights, int batch) {
+  if (batch == 1) {
+    weight_cpu_gemm(input, output, weights);
+    return;
+  }
+  CHECK_LE(batch, col_batch_);
+  const int col_stride = batch * conv_out_spatial_dim_;
+  Dtype* col_buff = batch_workspace_cpu(batch);
+  Dtype* output_buff = col_buff + kernel_dim_ * group_ * col_stride;
+  for (int n = 0; n < batch; ++n) {
+    conv_im2col_cpu(input + n * bottom_dim_, col_stride,
+        col_buff + n * conv_out_spatial_dim_);
+  }
+  gather_outputs(output, batch, output_buff);
+  for (int g = 0; g < group_; ++g) {
+    caffe_cpu_gemm<Dtype>(CblasNoTrans, CblasTrans, conv_out_channels_ / group_,
+        kernel_dim_, col_stride,
+        (Dtype)1., output_buff + conv_out_channels_ / group_ * col_stride * g,
+        col_buff + kernel_dim_ * col_stride * g,
+        (Dtype)1., weights + weight_offset_ * g);
+  }
+}
+
 #ifndef CPU_ONLY
 
 template <typename Dtype>
@@ -327,10 +452,11 @@ void BaseConvolutionLayer<Dtype>::forward_gpu_gemm(const Dtype* input,
     const Dtype* weights, Dtype* output, bool skip_im2col) {
   const Dtype* col_buff = input;
   if (!is_1x1_) {
+    Dtype* workspace = workspace_gpu(col_buffer_.count());
     if (!skip_im2col) {
-      conv_im2col_gpu(input, col_buffer_.mutable_gpu_data());
+      conv_im2col_gpu(input, workspace);
     }
-    col_buff = col_buffer_.gpu_data();
+    col_buff = workspace;
   }
   for (int g = 0; g < group_; ++g) {
     caffe_gpu_gemm<Dtype>(CblasNoTrans, CblasNoTrans, conv_out_channels_ /
@@ -351,9 +477,9 @@ void BaseConvolutionLayer<Dtype>::forward_gpu_bias(Dtype* output,
 template <typename Dtype>
 void BaseConvolutionLayer<Dtype>::backward_gpu_gemm(const Dtype* output,
     const Dtype* weights, Dtype* input) {
-  Dtype* col_buff = col_buffer_.mutable_gpu_data();
-  if (is_1x1_) {
-    col_buff = input;
+  Dtype* col_buff = input;
+  if (!is_1x1_) {
+    col_buff = workspace_gpu(col_buffer_.count());
   }
   for (int g = 0; g < group_; ++g) {
     caffe_gpu_gemm<Dtype>(CblasTrans, CblasNoTrans, kernel_dim_,
@@ -371,8 +497,9 @@ void BaseConvolutionLayer<Dtype>::weight_gpu_gemm(const Dtype* input,
     const Dtype* output, Dtype* weights) {
   const Dtype* col_buff = input;
   if (!is_1x1_) {
-    conv_im2col_gpu(input, col_buffer_.mutable_gpu_data());
-    col_buff = col_buffer_.gpu_data();
+    Dtype* workspace = workspace_gpu(col_buffer_.count());
+    conv_im2col_gpu(input, workspace);
+    col_buff = workspace;
   }
   for (int g = 0; g < group_; ++g) {
     caffe_gpu_gemm<Dtype>(CblasNoTrans, CblasTrans, conv_out_channels_ / group_,
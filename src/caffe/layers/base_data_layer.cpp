@@ -1,4 +1,5 @@
 #include <boost/thread.hpp>
+#include <algorithm>
 #include <vector>
 
 #include "caffe/blob.hpp"
@@ -7,7 +8,8 @@
 #include "caffe/layer.hpp"
 #include "caffe/layers/base_data_layer.hpp"
 #include "caffe/proto/caffe.pb.h"
-#include "caffe/util/blocking_queue.hpp"
+#include "caffe/util/benchmark.hpp"
+#include "caffe/util/bounded_queue.hpp"
 
 namespace caffe {
 
@@ -36,9 +38,15 @@ template <typename Dtype>
 BasePrefetchingDataLayer<Dtype>::BasePrefetchingDataLayer(
     const LayerParameter& param)
     : BaseDataLayer<Dtype>(param),
-      prefetch_free_(), prefetch_full_() {
-  for (int i = 0; i < PREFETCH_COUNT; ++i) {
-    prefetch_free_.push(&prefetch_[i]);
+      max_prefetch_(std::max<int>(param.data_param().prefetch(),
+          param.data_param().max_prefetch())),
+      prefetch_free_(max_prefetch_), prefetch_full_(max_prefetch_),
+      forward_count_(0), wait_count_(0), wait_ms_(0) {
+  const int prefetch = param.data_param().prefetch();
+  CHECK_GT(prefetch, 0) << "Data layers need to prefetch a batch.";
+  for (int i = 0; i < prefetch; ++i) {
+    prefetch_.push_back(shared_ptr<Batch<Dtype> >(new Batch<Dtype>()));
+    prefetch_free_.push(prefetch_[i].get());
   }
 }
 
@@ -50,18 +58,34 @@ void BasePrefetchingDataLayer<Dtype>::LayerSetUp(
   // calls so that the prefetch thread does not accidentally make simultaneous
   // cudaMalloc calls when the main thread is running. In some GPUs this
   // seems to cause failures if we do not so.
-  for (int i = 0; i < PREFETCH_COUNT; ++i) {
-    prefetch_[i].data_.mutable_cpu_data();
+  for (int i = 0; i < prefetch_.size(); ++i) {
+    prefetch_[i]->data_.mutable_cpu_data();
     if (this->output_labels_) {
-      prefetch_[i].label_.mutable_cpu_data();
+      prefetch_[i]->label_.mutable_cpu_data();
     }
   }
 #ifndef CPU_ONLY
   if (Caffe::mode() == Caffe::GPU) {
-    for (int i = 0; i < PREFETCH_COUNT; ++i) {
-      prefetch_[i].data_.mutable_gpu_data();
+    for (int i = prefetch_.size(); i < max_prefetch_; ++i) {
+      shared_ptr<Batch<Dtype> > spare(new Batch<Dtype>());
+      spare->data_.ReshapeLike(prefetch_[0]->data_);
+      spare->data_.mutable_cpu_data();
       if (this->output_labels_) {
-        prefetch_[i].label_.mutable_gpu_data();
+        spare->label_.ReshapeLike(prefetch_[0]->label_);
+        spare->label_.mutable_cpu_data();
+      }
+      prefetch_spare_.push_back(spare);
+    }
+    for (int i = 0; i < prefetch_.size(); ++i) {
+      prefetch_[i]->data_.mutable_gpu_data();
+      if (this->output_labels_) {
+        prefetch_[i]->label_.mutable_gpu_data();
+      }
+    }
+    for (int i = 0; i < prefetch_spare_.size(); ++i) {
+      prefetch_spare_[i]->data_.mutable_gpu_data();
+      if (this->output_labels_) {
+        prefetch_spare_[i]->label_.mutable_gpu_data();
       }
     }
   }
@@ -103,10 +127,47 @@ void BasePrefetchingDataLayer<Dtype>::InternalThreadEntry() {
 #endif
 }
 
+template <typename Dtype>
+Batch<Dtype>* BasePrefetchingDataLayer<Dtype>::NextBatch() {
+  ++forward_count_;
+  Batch<Dtype>* batch;
+  if (prefetch_full_.try_pop(&batch)) {
+    return batch;
+  }
+  CPUTimer timer;
+  timer.Start();
+  batch = prefetch_full_.pop("Data layer prefetch queue empty");
+  ++wait_count_;
+  wait_ms_ += timer.MilliSeconds();
+  // The first batch is waited for while the prefetch thread starts up.
+  if (forward_count_ > 1 && prefetch_.size() < max_prefetch_) {
+    shared_ptr<Batch<Dtype> > added;
+    if (!prefetch_spare_.empty()) {
+      added = prefetch_spare_.back();
+      prefetch_spare_.pop_back();
+    } else {
+      // Shaped like the batch at hand, which the prefetch thread isn't using.
+      added.reset(new Batch<Dtype>());
+      added->data_.ReshapeLike(batch->data_);
+      added->data_.mutable_cpu_data();
+      if (this->output_labels_) {
+        added->label_.ReshapeLike(batch->label_);
+        added->label_.mutable_cpu_data();
+      }
+    }
+    prefetch_.push_back(added);
+    prefetch_free_.push(added.get());
+    LOG(INFO) << this->layer_param_.name() << " waited for " << wait_count_
+        << " of " << forward_count_ << " batches (" << wait_ms_
+        << " ms); prefetching " << prefetch_.size() << " batches";
+  }
+  return batch;
+}
+
 template <typename Dtype>
 void BasePrefetchingDataLayer<Dtype>::Forward_cpu(
     const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
-  Batch<Dtype>* batch = prefetch_full_.pop("Data layer prefetch queue empty");
+  Batch<Dtype>* batch = NextBatch();
   // Reshape to loaded data.
   top[0]->ReshapeLike(batch->data_);
   // Copy the data
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <vector>
 
 #include "caffe/layers/conv_layer.hpp"
@@ -28,12 +29,16 @@ void ConvolutionLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
   for (int i = 0; i < bottom.size(); ++i) {
     const Dtype* bottom_data = bottom[i]->cpu_data();
     Dtype* top_data = top[i]->mutable_cpu_data();
-    for (int n = 0; n < this->num_; ++n) {
-      this->forward_cpu_gemm(bottom_data + n * this->bottom_dim_, weight,
-          top_data + n * this->top_dim_);
-      if (this->bias_term_) {
-        const Dtype* bias = this->blobs_[1]->cpu_data();
-        this->forward_cpu_bias(top_data + n * this->top_dim_, bias);
+    for (int n = 0; n < this->num_; n += this->col_batch_) {
+      const int batch = std::min(this->col_batch_, this->num_ - n);
+      this->forward_cpu_gemm_batch(bottom_data + n * this->bottom_dim_, weight,
+          top_data + n * this->top_dim_, batch);
+      for (int m = n; m < n + batch; ++m) {
+        if (this->bias_term_) {
+          this->forward_cpu_bias(top_data + m * this->top_dim_,
+              this->blobs_[1]->cpu_data());
+        }
+        forward_cpu_relu(top_data + m * this->top_dim_);
       }
     }
   }
@@ -45,6 +50,7 @@ void ConvolutionLayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
   const Dtype* weight = this->blobs_[0]->cpu_data();
   Dtype* weight_diff = this->blobs_[0]->mutable_cpu_diff();
   for (int i = 0; i < top.size(); ++i) {
+    backward_cpu_relu(top[i]);
     const Dtype* top_diff = top[i]->cpu_diff();
     const Dtype* bottom_data = bottom[i]->cpu_data();
     Dtype* bottom_diff = bottom[i]->mutable_cpu_diff();
@@ -56,22 +62,42 @@ void ConvolutionLayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
       }
     }
     if (this->param_propagate_down_[0] || propagate_down[i]) {
-      for (int n = 0; n < this->num_; ++n) {
+      for (int n = 0; n < this->num_; n += this->col_batch_) {
+        const int batch = std::min(this->col_batch_, this->num_ - n);
         // gradient w.r.t. weight. Note that we will accumulate diffs.
         if (this->param_propagate_down_[0]) {
-          this->weight_cpu_gemm(bottom_data + n * this->bottom_dim_,
-              top_diff + n * this->top_dim_, weight_diff);
+          this->weight_cpu_gemm_batch(bottom_data + n * this->bottom_dim_,
+              top_diff + n * this->top_dim_, weight_diff, batch);
         }
         // gradient w.r.t. bottom data, if necessary.
         if (propagate_down[i]) {
-          this->backward_cpu_gemm(top_diff + n * this->top_dim_, weight,
-              bottom_diff + n * this->bottom_dim_);
+          this->backward_cpu_gemm_batch(top_diff + n * this->top_dim_, weight,
+              bottom_diff + n * this->bottom_dim_, batch);
         }
       }
     }
   }
 }
 
+template <typename Dtype>
+void ConvolutionLayer<Dtype>::forward_cpu_relu(Dtype* output) {
+  if (!this->fused_relu_) { return; }
+  for (int i = 0; i < this->top_dim_; ++i) {
+    output[i] = std::max(output[i], Dtype(0));
+  }
+}
+
+template <typename Dtype>
+void ConvolutionLayer<Dtype>::backward_cpu_relu(Blob<Dtype>* top) {
+  if (!this->fused_relu_) { return; }
+  // Like an in-place ReLU, mask the diff the following layer left in top.
+  const Dtype* top_data = top->cpu_data();
+  Dtype* top_diff = top->mutable_cpu_diff();
+  for (int i = 0; i < top->count(); ++i) {
+    top_diff[i] *= (top_data[i] > 0);
+  }
+}
+
 #ifdef CPU_ONLY
 STUB_GPU(ConvolutionLayer);
 #endif
@@ -4,6 +4,40 @@
 
 namespace caffe {
 
+template <typename Dtype>
+__global__ void FusedReLUForward(const int n, Dtype* data) {
+  CUDA_KERNEL_LOOP(index, n) {
+    data[index] = data[index] > 0 ? data[index] : 0;
+  }
+}
+
+template <typename Dtype>
+__global__ void FusedReLUBackward(const int n, const Dtype* data,
+    Dtype* diff) {
+  CUDA_KERNEL_LOOP(index, n) {
+    diff[index] = data[index] > 0 ? diff[index] : 0;
+  }
+}
+
+template <typename Dtype>
+void ConvolutionLayer<Dtype>::forward_gpu_relu(Dtype* output) {
+  if (!this->fused_relu_) { return; }
+  // NOLINT_NEXT_LINE(whitespace/operators)
+  FusedReLUForward<Dtype><<<CAFFE_GET_BLOCKS(this->top_dim_),
+      CAFFE_CUDA_NUM_THREADS>>>(this->top_dim_, output);
+  CUDA_POST_KERNEL_CHECK;
+}
+
+template <typename Dtype>
+void ConvolutionLayer<Dtype>::backward_gpu_relu(Blob<Dtype>* top) {
+  if (!this->fused_relu_) { return; }
+  const int count = top->count();
+  // NOLINT_NEXT_LINE(whitespace/operators)
+  FusedReLUBackward<Dtype><<<CAFFE_GET_BLOCKS(count), CAFFE_CUDA_NUM_THREADS>>>(
+      count, top->gpu_data(), top->mutable_gpu_diff());
+  CUDA_POST_KERNEL_CHECK;
+}
+
 template <typename Dtype>
 void ConvolutionLayer<Dtype>::Forward_gpu(const vector<Blob<Dtype>*>& bottom,
       const vector<Blob<Dtype>*>& top) {
@@ -18,6 +52,7 @@ void ConvolutionLayer<Dtype>::Forward_gpu(const vector<Blob<Dtype>*>& bottom,
         const Dtype* bias = this->blobs_[1]->gpu_data();
         this->forward_gpu_bias(top_data + n * this->top_dim_, bias);
       }
+      forward_gpu_relu(top_data + n * this->top_dim_);
     }
   }
 }
@@ -28,6 +63,7 @@ void ConvolutionLayer<Dtype>::Backward_gpu(const vector<Blob<Dtype>*>& top,
   const Dtype* weight = this->blobs_[0]->gpu_data();
   Dtype* weight_diff = this->blobs_[0]->mutable_gpu_diff();
   for (int i = 0; i < top.size(); ++i) {
+    backward_gpu_relu(top[i]);
     const Dtype* top_diff = top[i]->gpu_diff();
     // Bias gradient, if necessary.
     if (this->bias_term_ && this->param_propagate_down_[1]) {
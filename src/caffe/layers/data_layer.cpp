@@ -3,6 +3,7 @@
 #endif  // USE_OPENCV
 #include <stdint.h>
 
+#include <boost/bind.hpp>
 #include <vector>
 
 #include "caffe/data_transformer.hpp"
@@ -14,7 +15,7 @@ namespace caffe {
 template <typename Dtype>
 DataLayer<Dtype>::DataLayer(const LayerParameter& param)
   : BasePrefetchingDataLayer<Dtype>(param),
-    reader_(param) {
+    reader_(param), loaded_items_(0), load_time_(0) {
 }
 
 template <typename Dtype>
@@ -35,8 +36,8 @@ void DataLayer<Dtype>::DataLayerSetUp(const vector<Blob<Dtype>*>& bottom,
   // Reshape top[0] and prefetch_data according to the batch_size.
   top_shape[0] = batch_size;
   top[0]->Reshape(top_shape);
-  for (int i = 0; i < this->PREFETCH_COUNT; ++i) {
-    this->prefetch_[i].data_.Reshape(top_shape);
+  for (int i = 0; i < this->prefetch_.size(); ++i) {
+    this->prefetch_[i]->data_.Reshape(top_shape);
   }
   LOG(INFO) << "output data size: " << top[0]->num() << ","
       << top[0]->channels() << "," << top[0]->height() << ","
@@ -45,10 +46,70 @@ void DataLayer<Dtype>::DataLayerSetUp(const vector<Blob<Dtype>*>& bottom,
   if (this->output_labels_) {
     vector<int> label_shape(1, batch_size);
     top[1]->Reshape(label_shape);
-    for (int i = 0; i < this->PREFETCH_COUNT; ++i) {
-      this->prefetch_[i].label_.Reshape(label_shape);
+    for (int i = 0; i < this->prefetch_.size(); ++i) {
+      this->prefetch_[i]->label_.Reshape(label_shape);
     }
   }
+  const int decode_threads = this->layer_param_.data_param().decode_threads();
+  CHECK_GE(decode_threads, 1) << "Data layers need a decode thread.";
+  if (decode_threads > 1) {
+    // The transformers draw their seeds here, so that runs with a fixed
+    // random seed see the same transformations.
+    transformers_.push_back(this->data_transformer_);
+    for (int i = 0; i < decode_threads; ++i) {
+      if (i > 0) {
+        transformers_.push_back(shared_ptr<DataTransformer<Dtype> >(
+            new DataTransformer<Dtype>(this->transform_param_,
+                this->phase_)));
+        transformers_.back()->InitRand();
+      }
+      transformed_blobs_.push_back(
+          shared_ptr<Blob<Dtype> >(new Blob<Dtype>()));
+      idle_transformers_.push(i);
+    }
+    decode_pool_.reset(new ThreadPool(decode_threads));
+  }
+}
+
+template <typename Dtype>
+void DataLayer<Dtype>::TransformItem(DataTransformer<Dtype>* transformer,
+    Blob<Dtype>* transformed_blob, Dtype* top_data, Dtype* top_label,
+    Datum* datum, int item_id) {
+  // Apply data transformations (mirror, scale, crop...)
+  transformed_blob->set_cpu_data(top_data +
+      item_id * transformed_blob->count());
+  transformer->Transform(*datum, transformed_blob);
+  // Copy label.
+  if (this->output_labels_) {
+    top_label[item_id] = datum->label();
+  }
+}
+
+// This function is called on the decode threads
+template <typename Dtype>
+void DataLayer<Dtype>::TransformItems(Dtype* top_data, Dtype* top_label,
+    Datum** datums, int begin, int end) {
+  const int batch_size = this->layer_param_.data_param().batch_size();
+  if (this->layer_param_.data_param().deterministic_decode()) {
+    const int workers = transformers_.size();
+    for (int worker = begin; worker < end; ++worker) {
+      for (int item_id = worker; item_id < batch_size; item_id += workers) {
+        TransformItem(transformers_[worker].get(),
+            transformed_blobs_[worker].get(), top_data, top_label,
+            datums[item_id], item_id);
+      }
+    }
+  } else {
+    // There are as many transformers as threads, so one is always idle.
+    int transformer;
+    CHECK(idle_transformers_.try_pop(&transformer));
+    for (int item_id = begin; item_id < end; ++item_id) {
+      TransformItem(transformers_[transformer].get(),
+          transformed_blobs_[transformer].get(), top_data, top_label,
+          datums[item_id], item_id);
+    }
+    idle_transformers_.push(transformer);
+  }
 }
 
 // This function is called on prefetch thread
@@ -69,6 +130,9 @@ void DataLayer<Dtype>::load_batch(Batch<Dtype>* batch) {
   // Use data_transformer to infer the expected blob shape from datum.
   vector<int> top_shape = this->data_transformer_->InferBlobShape(datum);
   this->transformed_data_.Reshape(top_shape);
+  for (int i = 0; i < transformed_blobs_.size(); ++i) {
+    transformed_blobs_[i]->Reshape(top_shape);
+  }
   // Reshape batch according to the batch_size.
   top_shape[0] = batch_size;
   batch->data_.Reshape(top_shape);
@@ -79,29 +143,59 @@ void DataLayer<Dtype>::load_batch(Batch<Dtype>* batch) {
   if (this->output_labels_) {
     top_label = batch->label_.mutable_cpu_data();
   }
-  for (int item_id = 0; item_id < batch_size; ++item_id) {
+  if (decode_pool_) {
+    // Take the whole batch from the reader, so that its order does not
+    // depend on the decode threads, then decode it in parallel.
     timer.Start();
-    // get a datum
-    Datum& datum = *(reader_.full().pop("Waiting for data"));
+    vector<Datum*> datums(batch_size);
+    for (int item_id = 0; item_id < batch_size; ++item_id) {
+      datums[item_id] = reader_.full().pop("Waiting for data");
+    }
     read_time += timer.MicroSeconds();
     timer.Start();
-    // Apply data transformations (mirror, scale, crop...)
-    int offset = batch->data_.offset(item_id);
-    this->transformed_data_.set_cpu_data(top_data + offset);
-    this->data_transformer_->Transform(datum, &(this->transformed_data_));
-    // Copy label.
-    if (this->output_labels_) {
-      top_label[item_id] = datum.label();
-    }
+    const bool deterministic =
+        this->layer_param_.data_param().deterministic_decode();
+    decode_pool_->Run(0, deterministic ? transformers_.size() : batch_size,
+        1, boost::bind(&DataLayer<Dtype>::TransformItems, this, top_data,
+            top_label, &datums[0], _1, _2));
     trans_time += timer.MicroSeconds();
+    for (int item_id = 0; item_id < batch_size; ++item_id) {
+      reader_.free().push(datums[item_id]);
+    }
+  } else {
+    for (int item_id = 0; item_id < batch_size; ++item_id) {
+      timer.Start();
+      // get a datum
+      Datum* datum = reader_.full().pop("Waiting for data");
+      read_time += timer.MicroSeconds();
+      timer.Start();
+      TransformItem(this->data_transformer_.get(), &this->transformed_data_,
+          top_data, top_label, datum, item_id);
+      trans_time += timer.MicroSeconds();
 
-    reader_.free().push(const_cast<Datum*>(&datum));
+      reader_.free().push(datum);
+    }
   }
   timer.Stop();
   batch_timer.Stop();
   DLOG(INFO) << "Prefetch batch: " << batch_timer.MilliSeconds() << " ms.";
   DLOG(INFO) << "     Read time: " << read_time / 1000 << " ms.";
   DLOG(INFO) << "Transform time: " << trans_time / 1000 << " ms.";
+  // Report how many items per second the layer could load if it never
+  // waited for the net, about once a minute.
+  loaded_items_ += batch_size;
+  load_time_ += batch_timer.MicroSeconds();
+  const boost::posix_time::ptime now =
+      boost::posix_time::microsec_clock::local_time();
+  if (last_log_.is_not_a_date_time()) {
+    last_log_ = now;
+  } else if ((now - last_log_).total_seconds() >= 60) {
+    LOG(INFO) << "Data layer " << this->layer_param_.name() << " loads "
+        << loaded_items_ / (load_time_ / 1e6) << " images/s.";
+    loaded_items_ = 0;
+    load_time_ = 0;
+    last_log_ = now;
+  }
 }
 
 INSTANTIATE_CLASS(DataLayer);
@@ -0,0 +1,233 @@
+#include <algorithm>
+#include <vector>
+
+#include "caffe/layers/direct_conv_layer.hpp"
+#include "caffe/util/math_functions.hpp"
+
+namespace caffe {
+
+template <typename Dtype>
+void DirectConvolutionLayer<Dtype>::Reshape(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  ConvolutionLayer<Dtype>::Reshape(bottom, top);
+  if (!use_tiles()) {
+    return;
+  }
+  const int col_rows = this->channels_ * this->kernel_shape_.cpu_data()[0] *
+      this->kernel_shape_.cpu_data()[1];
+  const int output_h = this->output_shape_[0];
+  const int output_w = this->output_shape_[1];
+  const size_t row_bytes = sizeof(Dtype) * col_rows * output_w;
+  const size_t tile_bytes =
+      this->layer_param_.convolution_param().column_tile_bytes();
+  tile_rows_ = std::max(1, std::min(output_h,
+      static_cast<int>(tile_bytes / row_bytes)));
+}
+
+template <typename Dtype>
+Dtype* DirectConvolutionLayer<Dtype>::tile_workspace() {
+  const int col_rows = this->blobs_[0]->count(1) * this->group_;
+  return this->workspace_cpu((col_rows + this->num_output_) * tile_rows_ *
+      this->output_shape_[1]);
+}
+
+template <typename Dtype>
+bool DirectConvolutionLayer<Dtype>::use_tiles() const {
+  return this->num_spatial_axes_ == 2 && !this->force_nd_im2col_ &&
+      !this->is_1x1_;
+}
+
+template <typename Dtype>
+void DirectConvolutionLayer<Dtype>::im2col_tile(const Dtype* input,
+    int row_begin, int row_end, Dtype* col) const {
+  const int height = this->conv_input_shape_.cpu_data()[1];
+  const int width = this->conv_input_shape_.cpu_data()[2];
+  const int kernel_h = this->kernel_shape_.cpu_data()[0];
+  const int kernel_w = this->kernel_shape_.cpu_data()[1];
+  const int pad_h = this->pad_.cpu_data()[0];
+  const int pad_w = this->pad_.cpu_data()[1];
+  const int stride_h = this->stride_.cpu_data()[0];
+  const int stride_w = this->stride_.cpu_data()[1];
+  const int dilation_h = this->dilation_.cpu_data()[0];
+  const int dilation_w = this->dilation_.cpu_data()[1];
+  const int output_w = this->output_shape_[1];
+  for (int c = 0; c < this->channels_; ++c) {
+    const Dtype* channel = input + c * height * width;
+    for (int kh = 0; kh < kernel_h; ++kh) {
+      for (int kw = 0; kw < kernel_w; ++kw) {
+        for (int oh = row_begin; oh < row_end; ++oh) {
+          const int h = oh * stride_h - pad_h + kh * dilation_h;
+          if (h < 0 || h >= height) {
+            caffe_set(output_w, Dtype(0), col);
+            col += output_w;
+            continue;
+          }
+          const Dtype* row = channel + h * width;
+          for (int ow = 0; ow < output_w; ++ow) {
+            const int w = ow * stride_w - pad_w + kw * dilation_w;
+            *(col++) = (w >= 0 && w < width) ? row[w] : Dtype(0);
+          }
+        }
+      }
+    }
+  }
+}
+
+template <typename Dtype>
+void DirectConvolutionLayer<Dtype>::col2im_tile(const Dtype* col,
+    int row_begin, int row_end, Dtype* input_diff) const {
+  const int height = this->conv_input_shape_.cpu_data()[1];
+  const int width = this->conv_input_shape_.cpu_data()[2];
+  const int kernel_h = this->kernel_shape_.cpu_data()[0];
+  const int kernel_w = this->kernel_shape_.cpu_data()[1];
+  const int pad_h = this->pad_.cpu_data()[0];
+  const int pad_w = this->pad_.cpu_data()[1];
+  const int stride_h = this->stride_.cpu_data()[0];
+  const int stride_w = this->stride_.cpu_data()[1];
+  const int dilation_h = this->dilation_.cpu_data()[0];
+  const int dilation_w = this->dilation_.cpu_data()[1];
+  const int output_w = this->output_shape_[1];
+  for (int c = 0; c < this->channels_; ++c) {
+    Dtype* channel = input_diff + c * height * width;
+    for (int kh = 0; kh < kernel_h; ++kh) {
+      for (int kw = 0; kw < kernel_w; ++kw) {
+        for (int oh = row_begin; oh < row_end; ++oh) {
+          const int h = oh * stride_h - pad_h + kh * dilation_h;
+          if (h < 0 || h >= height) {
+            col += output_w;
+            continue;
+          }
+          Dtype* row = channel + h * width;
+          for (int ow = 0; ow < output_w; ++ow, ++col) {
+            const int w = ow * stride_w - pad_w + kw * dilation_w;
+            if (w >= 0 && w < width) {
+              row[w] += *col;
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+template <typename Dtype>
+void DirectConvolutionLayer<Dtype>::Forward_cpu(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  if (!use_tiles()) {
+    // 1x1 convolution multiplies the input directly; see forward_cpu_gemm.
+    ConvolutionLayer<Dtype>::Forward_cpu(bottom, top);
+    return;
+  }
+  const Dtype* weight = this->blobs_[0]->cpu_data();
+  const int output_h = this->output_shape_[0];
+  const int output_w = this->output_shape_[1];
+  const int out_spatial_dim = output_h * output_w;
+  const int group_out = this->num_output_ / this->group_;
+  const int kernel_dim = this->blobs_[0]->count(1);
+  Dtype* col = tile_workspace();
+  Dtype* tile = col + kernel_dim * this->group_ * tile_rows_ * output_w;
+  for (int i = 0; i < bottom.size(); ++i) {
+    const Dtype* bottom_data = bottom[i]->cpu_data();
+    Dtype* top_data = top[i]->mutable_cpu_data();
+    for (int n = 0; n < this->num_; ++n) {
+      const Dtype* input = bottom_data + n * this->bottom_dim_;
+      Dtype* output = top_data + n * this->top_dim_;
+      for (int row = 0; row < output_h; row += tile_rows_) {
+        const int row_end = std::min(row + tile_rows_, output_h);
+        const int tile_dim = (row_end - row) * output_w;
+        im2col_tile(input, row, row_end, col);
+        for (int g = 0; g < this->group_; ++g) {
+          caffe_cpu_gemm<Dtype>(CblasNoTrans, CblasNoTrans, group_out,
+              tile_dim, kernel_dim, (Dtype)1.,
+              weight + this->weight_offset_ * g,
+              col + kernel_dim * tile_dim * g, (Dtype)0.,
+              tile + group_out * tile_dim * g);
+        }
+        for (int c = 0; c < this->num_output_; ++c) {
+          caffe_copy(tile_dim, tile + c * tile_dim,
+              output + c * out_spatial_dim + row * output_w);
+        }
+      }
+      if (this->bias_term_) {
+        this->forward_cpu_bias(output, this->blobs_[1]->cpu_data());
+      }
+      this->forward_cpu_relu(output);
+    }
+  }
+}
+
+template <typename Dtype>
+void DirectConvolutionLayer<Dtype>::Backward_cpu(
+    const vector<Blob<Dtype>*>& top, const vector<bool>& propagate_down,
+    const vector<Blob<Dtype>*>& bottom) {
+  if (!use_tiles()) {
+    ConvolutionLayer<Dtype>::Backward_cpu(top, propagate_down, bottom);
+    return;
+  }
+  const Dtype* weight = this->blobs_[0]->cpu_data();
+  Dtype* weight_diff = this->blobs_[0]->mutable_cpu_diff();
+  const int output_h = this->output_shape_[0];
+  const int output_w = this->output_shape_[1];
+  const int out_spatial_dim = output_h * output_w;
+  const int group_out = this->num_output_ / this->group_;
+  const int kernel_dim = this->blobs_[0]->count(1);
+  Dtype* col = tile_workspace();
+  Dtype* tile = col + kernel_dim * this->group_ * tile_rows_ * output_w;
+  for (int i = 0; i < top.size(); ++i) {
+    this->backward_cpu_relu(top[i]);
+    const Dtype* top_diff = top[i]->cpu_diff();
+    const Dtype* bottom_data = bottom[i]->cpu_data();
+    Dtype* bottom_diff = bottom[i]->mutable_cpu_diff();
+    // Bias gradient, if necessary.
+    if (this->bias_term_ && this->param_propagate_down_[1]) {
+      Dtype* bias_diff = this->blobs_[1]->mutable_cpu_diff();
+      for (int n = 0; n < this->num_; ++n) {
+        this->backward_cpu_bias(bias_diff, top_diff + n * this->top_dim_);
+      }
+    }
+    if (!this->param_propagate_down_[0] && !propagate_down[i]) {
+      continue;
+    }
+    for (int n = 0; n < this->num_; ++n) {
+      const Dtype* output_diff = top_diff + n * this->top_dim_;
+      if (propagate_down[i]) {
+        caffe_set(this->bottom_dim_, Dtype(0),
+            bottom_diff + n * this->bottom_dim_);
+      }
+      for (int row = 0; row < output_h; row += tile_rows_) {
+        const int row_end = std::min(row + tile_rows_, output_h);
+        const int tile_dim = (row_end - row) * output_w;
+        for (int c = 0; c < this->num_output_; ++c) {
+          caffe_copy(tile_dim, output_diff + c * out_spatial_dim +
+              row * output_w, tile + c * tile_dim);
+        }
+        // gradient w.r.t. weight. Note that we will accumulate diffs.
+        if (this->param_propagate_down_[0]) {
+          im2col_tile(bottom_data + n * this->bottom_dim_, row, row_end, col);
+          for (int g = 0; g < this->group_; ++g) {
+            caffe_cpu_gemm<Dtype>(CblasNoTrans, CblasTrans, group_out,
+                kernel_dim, tile_dim, (Dtype)1.,
+                tile + group_out * tile_dim * g,
+                col + kernel_dim * tile_dim * g, (Dtype)1.,
+                weight_diff + this->weight_offset_ * g);
+          }
+        }
+        // gradient w.r.t. bottom data, if necessary.
+        if (propagate_down[i]) {
+          for (int g = 0; g < this->group_; ++g) {
+            caffe_cpu_gemm<Dtype>(CblasTrans, CblasNoTrans, kernel_dim,
+                tile_dim, group_out, (Dtype)1.,
+                weight + this->weight_offset_ * g,
+                tile + group_out * tile_dim * g, (Dtype)0.,
+                col + kernel_dim * tile_dim * g);
+          }
+          col2im_tile(col, row, row_end, bottom_diff + n * this->bottom_dim_);
+        }
+      }
+    }
+  }
+}
+
+INSTANTIATE_CLASS(DirectConvolutionLayer);
+
+}  // namespace caffe
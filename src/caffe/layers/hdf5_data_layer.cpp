@@ -1,11 +1,11 @@
 /*
 TODO:
-- load file in a separate thread ("prefetch")
 - can be smarter about the memcpy call instead of doing it row-by-row
   :: use util functions caffe_copy, and Blob->offset()
   :: don't forget to update hdf5_daa_layer.cu accordingly
-- add ability to shuffle filenames if flag is set
 */
+#include <boost/thread.hpp>
+#include <algorithm>
 #include <fstream>  // NOLINT(readability/streams)
 #include <string>
 #include <vector>
@@ -20,38 +20,79 @@ TODO:
 namespace caffe {
 
 template <typename Dtype>
-HDF5DataLayer<Dtype>::~HDF5DataLayer<Dtype>() { }
+HDF5DataLayer<Dtype>::~HDF5DataLayer<Dtype>() {
+  this->StopInternalThread();
+}
 
-// Load data and label from HDF5 filename into the class property blobs.
+// Load rows of data and label from HDF5 filename into the blobs of chunk.
 template <typename Dtype>
-void HDF5DataLayer<Dtype>::LoadHDF5FileData(const char* filename) {
-  DLOG(INFO) << "Loading HDF5 file: " << filename;
+bool HDF5DataLayer<Dtype>::LoadHDF5FileData(const char* filename,
+    hsize_t begin, HDF5Chunk<Dtype>* chunk) {
+  DLOG(INFO) << "Loading HDF5 file: " << filename << " from row " << begin;
+  // Forward may use HDF5 on another thread meanwhile.
+  HDF5Lock lock;
   hid_t file_id = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT);
   if (file_id < 0) {
     LOG(FATAL) << "Failed opening HDF5 file: " << filename;
   }
 
   int top_size = this->layer_param_.top_size();
-  hdf_blobs_.resize(top_size);
+  chunk->blobs_.resize(top_size);
 
   const int MIN_DATA_DIM = 1;
   const int MAX_DATA_DIM = INT_MAX;
 
+  const hsize_t rows =
+      hdf5_get_num_rows(file_id, this->layer_param_.top(0).c_str());
+  CHECK_LT(begin, rows) << "No rows left in HDF5 file: " << filename;
+  const hsize_t count = chunk_rows_ ?
+      std::min(chunk_rows_, rows - begin) : rows - begin;
   for (int i = 0; i < top_size; ++i) {
-    hdf_blobs_[i] = shared_ptr<Blob<Dtype> >(new Blob<Dtype>());
-    hdf5_load_nd_dataset(file_id, this->layer_param_.top(i).c_str(),
-        MIN_DATA_DIM, MAX_DATA_DIM, hdf_blobs_[i].get());
+    if (!chunk->blobs_[i]) {
+      chunk->blobs_[i].reset(new Blob<Dtype>());
+    }
+    hdf5_load_nd_dataset_rows(file_id, this->layer_param_.top(i).c_str(),
+        begin, count, MIN_DATA_DIM, MAX_DATA_DIM, chunk->blobs_[i].get());
   }
 
   herr_t status = H5Fclose(file_id);
   CHECK_GE(status, 0) << "Failed to close HDF5 file: " << filename;
 
   // MinTopBlobs==1 guarantees at least one top blob
-  CHECK_GE(hdf_blobs_[0]->num_axes(), 1) << "Input must have at least 1 axis.";
-  const int num = hdf_blobs_[0]->shape(0);
+  CHECK_GE(chunk->blobs_[0]->num_axes(), 1)
+      << "Input must have at least 1 axis.";
   for (int i = 1; i < top_size; ++i) {
-    CHECK_EQ(hdf_blobs_[i]->shape(0), num);
+    CHECK_EQ(chunk->blobs_[i]->shape(0), count);
   }
+  DLOG(INFO) << "Successully loaded " << count << " rows";
+  return begin + count == rows;
+}
+
+template <typename Dtype>
+void HDF5DataLayer<Dtype>::LoadNextChunk(HDF5Chunk<Dtype>* chunk) {
+  const bool end_of_file = LoadHDF5FileData(
+      hdf_filenames_[file_permutation_[current_file_]].c_str(),
+      current_file_row_, chunk);
+  current_file_row_ += chunk->blobs_[0]->shape(0);
+  if (end_of_file) {
+    current_file_row_ = 0;
+    ++current_file_;
+    if (current_file_ == num_files_) {
+      current_file_ = 0;
+      if (this->layer_param_.hdf5_data_param().shuffle()) {
+        std::random_shuffle(file_permutation_.begin(),
+                            file_permutation_.end());
+      }
+      DLOG(INFO) << "Looping around to first file.";
+    }
+  }
+}
+
+template <typename Dtype>
+void HDF5DataLayer<Dtype>::SetCurrentChunk(HDF5Chunk<Dtype>* chunk) {
+  current_chunk_ = chunk;
+  hdf_blobs_ = chunk->blobs_;
+  current_row_ = 0;
   // Default to identity permutation.
   data_permutation_.clear();
   data_permutation_.resize(hdf_blobs_[0]->shape(0));
@@ -61,10 +102,19 @@ void HDF5DataLayer<Dtype>::LoadHDF5FileData(const char* filename) {
   // Shuffle if needed.
   if (this->layer_param_.hdf5_data_param().shuffle()) {
     std::random_shuffle(data_permutation_.begin(), data_permutation_.end());
-    DLOG(INFO) << "Successully loaded " << hdf_blobs_[0]->shape(0)
-               << " rows (shuffled)";
-  } else {
-    DLOG(INFO) << "Successully loaded " << hdf_blobs_[0]->shape(0) << " rows";
+  }
+}
+
+template <typename Dtype>
+void HDF5DataLayer<Dtype>::InternalThreadEntry() {
+  try {
+    while (!must_stop()) {
+      HDF5Chunk<Dtype>* chunk = prefetch_free_.pop();
+      LoadNextChunk(chunk);
+      prefetch_full_.push(chunk);
+    }
+  } catch (boost::thread_interrupted&) {
+    // Interrupted exception is expected on shutdown
   }
 }
 
@@ -74,6 +124,11 @@ void HDF5DataLayer<Dtype>::LayerSetUp(const vector<Blob<Dtype>*>& bottom,
   // Refuse transformation parameters since HDF5 is totally generic.
   CHECK(!this->layer_param_.has_transform_param()) <<
       this->type() << " does not transform data.";
+  // Set up anew, without the chunks of an earlier setup.
+  this->StopInternalThread();
+  HDF5Chunk<Dtype>* chunk;
+  while (prefetch_free_.try_pop(&chunk) || prefetch_full_.try_pop(&chunk)) {
+  }
   // Read the source to parse the filenames.
   const string& source = this->layer_param_.hdf5_data_param().source();
   LOG(INFO) << "Loading list of HDF5 filenames from: " << source;
@@ -90,6 +145,8 @@ void HDF5DataLayer<Dtype>::LayerSetUp(const vector<Blob<Dtype>*>& bottom,
   source_file.close();
   num_files_ = hdf_filenames_.size();
   current_file_ = 0;
+  current_file_row_ = 0;
+  chunk_rows_ = this->layer_param_.hdf5_data_param().chunk_rows();
   LOG(INFO) << "Number of HDF5 files: " << num_files_;
   CHECK_GE(num_files_, 1) << "Must have at least 1 HDF5 filename listed in "
     << source;
@@ -106,9 +163,16 @@ void HDF5DataLayer<Dtype>::LayerSetUp(const vector<Blob<Dtype>*>& bottom,
     std::random_shuffle(file_permutation_.begin(), file_permutation_.end());
   }
 
-  // Load the first HDF5 file and initialize the line counter.
-  LoadHDF5FileData(hdf_filenames_[file_permutation_[current_file_]].c_str());
-  current_row_ = 0;
+  // Load the first chunk and initialize the line counter.
+  LoadNextChunk(&prefetch_[0]);
+  SetCurrentChunk(&prefetch_[0]);
+  // Unless it holds all the data, load the next chunks in the background.
+  if (num_files_ > 1 || current_file_row_ > 0) {
+    for (int i = 1; i < PREFETCH_COUNT; ++i) {
+      prefetch_free_.push(&prefetch_[i]);
+    }
+    this->StartInternalThread();
+  }
 
   // Reshape blobs.
   const int batch_size = this->layer_param_.hdf5_data_param().batch_size();
@@ -130,22 +194,12 @@ void HDF5DataLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
   const int batch_size = this->layer_param_.hdf5_data_param().batch_size();
   for (int i = 0; i < batch_size; ++i, ++current_row_) {
     if (current_row_ == hdf_blobs_[0]->shape(0)) {
-      if (num_files_ > 1) {
-        ++current_file_;
-        if (current_file_ == num_files_) {
-          current_file_ = 0;
-          if (this->layer_param_.hdf5_data_param().shuffle()) {
-            std::random_shuffle(file_permutation_.begin(),
-                                file_permutation_.end());
-          }
-          DLOG(INFO) << "Looping around to first file.";
-        }
-        LoadHDF5FileData(
-            hdf_filenames_[file_permutation_[current_file_]].c_str());
+      if (this->is_started()) {
+        prefetch_free_.push(current_chunk_);
+        SetCurrentChunk(prefetch_full_.pop("HDF5 prefetch queue empty"));
+      } else {
+        SetCurrentChunk(current_chunk_);
       }
-      current_row_ = 0;
-      if (this->layer_param_.hdf5_data_param().shuffle())
-        std::random_shuffle(data_permutation_.begin(), data_permutation_.end());
     }
     for (int j = 0; j < this->layer_param_.top_size(); ++j) {
       int data_dim = top[j]->count() / top[j]->shape(0);
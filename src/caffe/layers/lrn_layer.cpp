@@ -1,7 +1,9 @@
+#include <boost/bind.hpp>
 #include <vector>
 
 #include "caffe/layers/lrn_layer.hpp"
 #include "caffe/util/math_functions.hpp"
+#include "caffe/util/thread_pool.hpp"
 
 namespace caffe {
 
@@ -114,41 +116,51 @@ void LRNLayer<Dtype>::CrossChannelForward_cpu(
   for (int i = 0; i < scale_.count(); ++i) {
     scale_data[i] = k_;
   }
-  Blob<Dtype> padded_square(1, channels_ + size_ - 1, height_, width_);
-  Dtype* padded_square_data = padded_square.mutable_cpu_data();
-  caffe_set(padded_square.count(), Dtype(0), padded_square_data);
-  Dtype alpha_over_size = alpha_ / size_;
   // go through the images
-  for (int n = 0; n < num_; ++n) {
+  parallel_for(0, num_, boost::bind(&LRNLayer<Dtype>::CrossChannelForwardImages,
+      this, bottom_data, scale_data, _1, _2));
+
+  // In the end, compute output
+  caffe_powx<Dtype>(scale_.count(), scale_data, -beta_, top_data);
+  caffe_mul<Dtype>(scale_.count(), top_data, bottom_data, top_data);
+}
+
+template <typename Dtype>
+void LRNLayer<Dtype>::CrossChannelForwardImages(const Dtype* bottom_data,
+    Dtype* scale_data, int image_begin, int image_end) const {
+  // The padded squares live in the running thread's workspace. Only the
+  // padding channels need zeros; the others are rewritten for every image.
+  const int plane = height_ * width_;
+  Dtype* padded_square_data = static_cast<Dtype*>(Caffe::cpu_workspace(
+      (channels_ + size_ - 1) * plane * sizeof(Dtype))->mutable_cpu_data());
+  caffe_set(pre_pad_ * plane, Dtype(0), padded_square_data);
+  caffe_set((size_ - 1 - pre_pad_) * plane, Dtype(0),
+      padded_square_data + (pre_pad_ + channels_) * plane);
+  Dtype alpha_over_size = alpha_ / size_;
+  for (int n = image_begin; n < image_end; ++n) {
     // compute the padded square
-    caffe_sqr(channels_ * height_ * width_,
-        bottom_data + bottom[0]->offset(n),
-        padded_square_data + padded_square.offset(0, pre_pad_));
+    caffe_sqr(channels_ * plane, bottom_data + scale_.offset(n),
+        padded_square_data + pre_pad_ * plane);
     // Create the first channel scale
     for (int c = 0; c < size_; ++c) {
-      caffe_axpy<Dtype>(height_ * width_, alpha_over_size,
-          padded_square_data + padded_square.offset(0, c),
-          scale_data + scale_.offset(n, 0));
+      caffe_axpy<Dtype>(plane, alpha_over_size,
+          padded_square_data + c * plane, scale_data + scale_.offset(n, 0));
     }
     for (int c = 1; c < channels_; ++c) {
       // copy previous scale
-      caffe_copy<Dtype>(height_ * width_,
+      caffe_copy<Dtype>(plane,
           scale_data + scale_.offset(n, c - 1),
           scale_data + scale_.offset(n, c));
       // add head
-      caffe_axpy<Dtype>(height_ * width_, alpha_over_size,
-          padded_square_data + padded_square.offset(0, c + size_ - 1),
+      caffe_axpy<Dtype>(plane, alpha_over_size,
+          padded_square_data + (c + size_ - 1) * plane,
           scale_data + scale_.offset(n, c));
       // subtract tail
-      caffe_axpy<Dtype>(height_ * width_, -alpha_over_size,
-          padded_square_data + padded_square.offset(0, c - 1),
+      caffe_axpy<Dtype>(plane, -alpha_over_size,
+          padded_square_data + (c - 1) * plane,
           scale_data + scale_.offset(n, c));
     }
   }
-
-  // In the end, compute output
-  caffe_powx<Dtype>(scale_.count(), scale_data, -beta_, top_data);
-  caffe_mul<Dtype>(scale_.count(), top_data, bottom_data, top_data);
 }
 
 template <typename Dtype>
@@ -185,48 +197,60 @@ void LRNLayer<Dtype>::CrossChannelBackward_cpu(
   const Dtype* bottom_data = bottom[0]->cpu_data();
   const Dtype* scale_data = scale_.cpu_data();
   Dtype* bottom_diff = bottom[0]->mutable_cpu_diff();
-  Blob<Dtype> padded_ratio(1, channels_ + size_ - 1, height_, width_);
-  Blob<Dtype> accum_ratio(1, 1, height_, width_);
-  Dtype* padded_ratio_data = padded_ratio.mutable_cpu_data();
-  Dtype* accum_ratio_data = accum_ratio.mutable_cpu_data();
-  // We hack a little bit by using the diff() to store an additional result
-  Dtype* accum_ratio_times_bottom = accum_ratio.mutable_cpu_diff();
-  caffe_set(padded_ratio.count(), Dtype(0), padded_ratio_data);
-  Dtype cache_ratio_value = 2. * alpha_ * beta_ / size_;
 
   caffe_powx<Dtype>(scale_.count(), scale_data, -beta_, bottom_diff);
   caffe_mul<Dtype>(scale_.count(), top_diff, bottom_diff, bottom_diff);
 
   // go through individual data
+  parallel_for(0, num_, boost::bind(
+      &LRNLayer<Dtype>::CrossChannelBackwardImages, this, top_diff, top_data,
+      bottom_data, scale_data, bottom_diff, _1, _2));
+}
+
+template <typename Dtype>
+void LRNLayer<Dtype>::CrossChannelBackwardImages(const Dtype* top_diff,
+    const Dtype* top_data, const Dtype* bottom_data, const Dtype* scale_data,
+    Dtype* bottom_diff, int image_begin, int image_end) const {
+  // The padded ratios and two planes of accumulators live in the running
+  // thread's workspace; as in the forward pass only the padding needs zeros.
+  const int plane = height_ * width_;
+  const int padded_count = (channels_ + size_ - 1) * plane;
+  Dtype* padded_ratio_data = static_cast<Dtype*>(Caffe::cpu_workspace(
+      (padded_count + 2 * plane) * sizeof(Dtype))->mutable_cpu_data());
+  Dtype* accum_ratio_data = padded_ratio_data + padded_count;
+  Dtype* accum_ratio_times_bottom = accum_ratio_data + plane;
+  Dtype cache_ratio_value = 2. * alpha_ * beta_ / size_;
   int inverse_pre_pad = size_ - (size_ + 1) / 2;
-  for (int n = 0; n < num_; ++n) {
+  caffe_set(inverse_pre_pad * plane, Dtype(0), padded_ratio_data);
+  caffe_set((size_ - 1 - inverse_pre_pad) * plane, Dtype(0),
+      padded_ratio_data + (inverse_pre_pad + channels_) * plane);
+  for (int n = image_begin; n < image_end; ++n) {
     int block_offset = scale_.offset(n);
     // first, compute diff_i * y_i / s_i
-    caffe_mul<Dtype>(channels_ * height_ * width_,
+    caffe_mul<Dtype>(channels_ * plane,
         top_diff + block_offset, top_data + block_offset,
-        padded_ratio_data + padded_ratio.offset(0, inverse_pre_pad));
-    caffe_div<Dtype>(channels_ * height_ * width_,
-        padded_ratio_data + padded_ratio.offset(0, inverse_pre_pad),
+        padded_ratio_data + inverse_pre_pad * plane);
+    caffe_div<Dtype>(channels_ * plane,
+        padded_ratio_data + inverse_pre_pad * plane,
         scale_data + block_offset,
-        padded_ratio_data + padded_ratio.offset(0, inverse_pre_pad));
+        padded_ratio_data + inverse_pre_pad * plane);
     // Now, compute the accumulated ratios and the bottom diff
-    caffe_set(accum_ratio.count(), Dtype(0), accum_ratio_data);
+    caffe_set(plane, Dtype(0), accum_ratio_data);
     for (int c = 0; c < size_ - 1; ++c) {
-      caffe_axpy<Dtype>(height_ * width_, 1.,
-          padded_ratio_data + padded_ratio.offset(0, c), accum_ratio_data);
+      caffe_axpy<Dtype>(plane, 1., padded_ratio_data + c * plane,
+          accum_ratio_data);
     }
     for (int c = 0; c < channels_; ++c) {
-      caffe_axpy<Dtype>(height_ * width_, 1.,
-          padded_ratio_data + padded_ratio.offset(0, c + size_ - 1),
-          accum_ratio_data);
+      caffe_axpy<Dtype>(plane, 1.,
+          padded_ratio_data + (c + size_ - 1) * plane, accum_ratio_data);
       // compute bottom diff
-      caffe_mul<Dtype>(height_ * width_,
-          bottom_data + top[0]->offset(n, c),
+      caffe_mul<Dtype>(plane,
+          bottom_data + scale_.offset(n, c),
           accum_ratio_data, accum_ratio_times_bottom);
-      caffe_axpy<Dtype>(height_ * width_, -cache_ratio_value,
-          accum_ratio_times_bottom, bottom_diff + top[0]->offset(n, c));
-      caffe_axpy<Dtype>(height_ * width_, -1.,
-          padded_ratio_data + padded_ratio.offset(0, c), accum_ratio_data);
+      caffe_axpy<Dtype>(plane, -cache_ratio_value,
+          accum_ratio_times_bottom, bottom_diff + scale_.offset(n, c));
+      caffe_axpy<Dtype>(plane, -1.,
+          padded_ratio_data + c * plane, accum_ratio_data);
     }
   }
 }
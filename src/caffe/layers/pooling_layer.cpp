@@ -1,9 +1,11 @@
+#include <boost/bind.hpp>
 #include <algorithm>
 #include <cfloat>
 #include <vector>
 
 #include "caffe/layers/pooling_layer.hpp"
 #include "caffe/util/math_functions.hpp"
+#include "caffe/util/thread_pool.hpp"
 
 namespace caffe {
 
@@ -35,6 +37,7 @@ void PoolingLayer<Dtype>::LayerSetUp(const vector<Blob<Dtype>*>& bottom,
       || (!pool_param.has_stride_h() && !pool_param.has_stride_w()))
       << "Stride is stride OR stride_h and stride_w are required.";
   global_pooling_ = pool_param.global_pooling();
+  num_threads_ = pool_param.num_threads();
   if (global_pooling_) {
     kernel_h_ = bottom[0]->height();
     kernel_w_ = bottom[0]->width();
@@ -122,101 +125,236 @@ void PoolingLayer<Dtype>::Reshape(const vector<Blob<Dtype>*>& bottom,
   }
 }
 
-// TODO(Yangqing): Is there a faster way to do pooling in the channel-first
-// case?
+// Max pool the outputs of a K x K, stride 2, unpadded pooling whose windows
+// lie entirely inside the plane, i.e. the first full_h x full_w outputs.
+// With K a compile-time constant the window unrolls and the compare/select
+// chain is branch-free, so the compiler can vectorize along the row. The
+// visiting order, and thus the argmax chosen on ties, matches the generic loop.
+template <int K, typename Dtype, typename MaskType>
+static void max_pool_stride2(const Dtype* bottom_data, const int width,
+    const int full_h, const int full_w, const int pooled_width,
+    Dtype* top_data, MaskType* mask) {
+  for (int ph = 0; ph < full_h; ++ph) {
+    Dtype* top_row = top_data + ph * pooled_width;
+    MaskType* mask_row = mask + ph * pooled_width;
+    for (int pw = 0; pw < full_w; ++pw) {
+      Dtype maxval = -FLT_MAX;
+      int maxidx = -1;
+      for (int kh = 0; kh < K; ++kh) {
+        for (int kw = 0; kw < K; ++kw) {
+          const int index = (2 * ph + kh) * width + 2 * pw + kw;
+          const bool greater = bottom_data[index] > maxval;
+          maxval = greater ? bottom_data[index] : maxval;
+          maxidx = greater ? index : maxidx;
+        }
+      }
+      top_row[pw] = maxval;
+      mask_row[pw] = static_cast<MaskType>(maxidx);
+    }
+  }
+}
+
+// Average pooling counterpart of max_pool_stride2.
+template <int K, typename Dtype>
+static void ave_pool_stride2(const Dtype* bottom_data, const int width,
+    const int full_h, const int full_w, const int pooled_width,
+    Dtype* top_data) {
+  for (int ph = 0; ph < full_h; ++ph) {
+    Dtype* top_row = top_data + ph * pooled_width;
+    for (int pw = 0; pw < full_w; ++pw) {
+      Dtype sum = 0;
+      for (int kh = 0; kh < K; ++kh) {
+        for (int kw = 0; kw < K; ++kw) {
+          sum += bottom_data[(2 * ph + kh) * width + 2 * pw + kw];
+        }
+      }
+      top_row[pw] = sum / (K * K);
+    }
+  }
+}
+
+template <typename Dtype>
+int PoolingLayer<Dtype>::UnrolledKernelSize(int* full_h, int* full_w) const {
+  *full_h = *full_w = 0;
+  if (kernel_h_ != kernel_w_ || (kernel_h_ != 2 && kernel_h_ != 3) ||
+      stride_h_ != 2 || stride_w_ != 2 || pad_h_ != 0 || pad_w_ != 0) {
+    return 0;
+  }
+  *full_h = min(max((height_ - kernel_h_) / 2 + 1, 0), pooled_height_);
+  *full_w = min(max((width_ - kernel_w_) / 2 + 1, 0), pooled_width_);
+  return kernel_h_;
+}
+
+template <typename Dtype>
+template <typename MaskType>
+void PoolingLayer<Dtype>::MaxPoolPlanes(const Dtype* bottom_data,
+      Dtype* top_data, MaskType* mask, int plane_begin, int plane_end) const {
+  int full_h, full_w;
+  const int unrolled_kernel = UnrolledKernelSize(&full_h, &full_w);
+  bottom_data += plane_begin * height_ * width_;
+  top_data += plane_begin * pooled_height_ * pooled_width_;
+  mask += plane_begin * pooled_height_ * pooled_width_;
+  for (int i = plane_begin; i < plane_end; ++i) {
+    if (unrolled_kernel == 2) {
+      max_pool_stride2<2>(bottom_data, width_, full_h, full_w, pooled_width_,
+          top_data, mask);
+    } else if (unrolled_kernel == 3) {
+      max_pool_stride2<3>(bottom_data, width_, full_h, full_w, pooled_width_,
+          top_data, mask);
+    }
+    for (int ph = 0; ph < pooled_height_; ++ph) {
+      for (int pw = (ph < full_h ? full_w : 0); pw < pooled_width_; ++pw) {
+        int hstart = ph * stride_h_ - pad_h_;
+        int wstart = pw * stride_w_ - pad_w_;
+        int hend = min(hstart + kernel_h_, height_);
+        int wend = min(wstart + kernel_w_, width_);
+        hstart = max(hstart, 0);
+        wstart = max(wstart, 0);
+        Dtype maxval = -FLT_MAX;
+        int maxidx = -1;
+        for (int h = hstart; h < hend; ++h) {
+          for (int w = wstart; w < wend; ++w) {
+            const int index = h * width_ + w;
+            if (bottom_data[index] > maxval) {
+              maxval = bottom_data[index];
+              maxidx = index;
+            }
+          }
+        }
+        const int pool_index = ph * pooled_width_ + pw;
+        top_data[pool_index] = maxval;
+        mask[pool_index] = static_cast<MaskType>(maxidx);
+      }
+    }
+    bottom_data += height_ * width_;
+    top_data += pooled_height_ * pooled_width_;
+    mask += pooled_height_ * pooled_width_;
+  }
+}
+
+template <typename Dtype>
+void PoolingLayer<Dtype>::AvePoolPlanes(const Dtype* bottom_data,
+      Dtype* top_data, int plane_begin, int plane_end) const {
+  int full_h, full_w;
+  const int unrolled_kernel = UnrolledKernelSize(&full_h, &full_w);
+  bottom_data += plane_begin * height_ * width_;
+  top_data += plane_begin * pooled_height_ * pooled_width_;
+  for (int i = plane_begin; i < plane_end; ++i) {
+    if (unrolled_kernel == 2) {
+      ave_pool_stride2<2>(bottom_data, width_, full_h, full_w, pooled_width_,
+          top_data);
+    } else if (unrolled_kernel == 3) {
+      ave_pool_stride2<3>(bottom_data, width_, full_h, full_w, pooled_width_,
+          top_data);
+    }
+    for (int ph = 0; ph < pooled_height_; ++ph) {
+      for (int pw = (ph < full_h ? full_w : 0); pw < pooled_width_; ++pw) {
+        int hstart = ph * stride_h_ - pad_h_;
+        int wstart = pw * stride_w_ - pad_w_;
+        int hend = min(hstart + kernel_h_, height_ + pad_h_);
+        int wend = min(wstart + kernel_w_, width_ + pad_w_);
+        int pool_size = (hend - hstart) * (wend - wstart);
+        hstart = max(hstart, 0);
+        wstart = max(wstart, 0);
+        hend = min(hend, height_);
+        wend = min(wend, width_);
+        Dtype sum = 0;
+        for (int h = hstart; h < hend; ++h) {
+          for (int w = wstart; w < wend; ++w) {
+            sum += bottom_data[h * width_ + w];
+          }
+        }
+        top_data[ph * pooled_width_ + pw] = sum / pool_size;
+      }
+    }
+    bottom_data += height_ * width_;
+    top_data += pooled_height_ * pooled_width_;
+  }
+}
+
+template <typename Dtype>
+template <typename MaskType>
+void PoolingLayer<Dtype>::MaxUnpoolPlanes(const Dtype* top_diff,
+      const MaskType* mask, Dtype* bottom_diff, int plane_begin,
+      int plane_end) const {
+  top_diff += plane_begin * pooled_height_ * pooled_width_;
+  mask += plane_begin * pooled_height_ * pooled_width_;
+  bottom_diff += plane_begin * height_ * width_;
+  for (int i = plane_begin; i < plane_end; ++i) {
+    for (int index = 0; index < pooled_height_ * pooled_width_; ++index) {
+      const int bottom_index = static_cast<int>(mask[index]);
+      bottom_diff[bottom_index] += top_diff[index];
+    }
+    top_diff += pooled_height_ * pooled_width_;
+    mask += pooled_height_ * pooled_width_;
+    bottom_diff += height_ * width_;
+  }
+}
+
+template <typename Dtype>
+void PoolingLayer<Dtype>::AveUnpoolPlanes(const Dtype* top_diff,
+      Dtype* bottom_diff, int plane_begin, int plane_end) const {
+  top_diff += plane_begin * pooled_height_ * pooled_width_;
+  bottom_diff += plane_begin * height_ * width_;
+  for (int i = plane_begin; i < plane_end; ++i) {
+    for (int ph = 0; ph < pooled_height_; ++ph) {
+      for (int pw = 0; pw < pooled_width_; ++pw) {
+        int hstart = ph * stride_h_ - pad_h_;
+        int wstart = pw * stride_w_ - pad_w_;
+        int hend = min(hstart + kernel_h_, height_ + pad_h_);
+        int wend = min(wstart + kernel_w_, width_ + pad_w_);
+        int pool_size = (hend - hstart) * (wend - wstart);
+        hstart = max(hstart, 0);
+        wstart = max(wstart, 0);
+        hend = min(hend, height_);
+        wend = min(wend, width_);
+        for (int h = hstart; h < hend; ++h) {
+          for (int w = wstart; w < wend; ++w) {
+            bottom_diff[h * width_ + w] +=
+              top_diff[ph * pooled_width_ + pw] / pool_size;
+          }
+        }
+      }
+    }
+    top_diff += pooled_height_ * pooled_width_;
+    bottom_diff += height_ * width_;
+  }
+}
+
+template <typename Dtype>
+int PoolingLayer<Dtype>::PlaneGrain(const int num_planes) const {
+  return num_threads_ > 0 ? (num_planes + num_threads_ - 1) / num_threads_ : 1;
+}
+
+// The (num x channels) planes are pooled independently, so they are split
+// across the CPU thread pool.
 template <typename Dtype>
 void PoolingLayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
       const vector<Blob<Dtype>*>& top) {
   const Dtype* bottom_data = bottom[0]->cpu_data();
   Dtype* top_data = top[0]->mutable_cpu_data();
-  const int top_count = top[0]->count();
+  const int num_planes = bottom[0]->num() * channels_;
+  const int grain = PlaneGrain(num_planes);
   // We'll output the mask to top[1] if it's of size >1.
   const bool use_top_mask = top.size() > 1;
-  int* mask = NULL;  // suppress warnings about uninitalized variables
-  Dtype* top_mask = NULL;
   // Different pooling methods. We explicitly do the switch outside the for
   // loop to save time, although this results in more code.
   switch (this->layer_param_.pooling_param().pool()) {
   case PoolingParameter_PoolMethod_MAX:
-    // Initialize
     if (use_top_mask) {
-      top_mask = top[1]->mutable_cpu_data();
-      caffe_set(top_count, Dtype(-1), top_mask);
+      parallel_for(0, num_planes, boost::bind(
+          &PoolingLayer<Dtype>::template MaxPoolPlanes<Dtype>, this,
+          bottom_data, top_data, top[1]->mutable_cpu_data(), _1, _2), grain);
     } else {
-      mask = max_idx_.mutable_cpu_data();
-      caffe_set(top_count, -1, mask);
-    }
-    caffe_set(top_count, Dtype(-FLT_MAX), top_data);
-    // The main loop
-    for (int n = 0; n < bottom[0]->num(); ++n) {
-      for (int c = 0; c < channels_; ++c) {
-        for (int ph = 0; ph < pooled_height_; ++ph) {
-          for (int pw = 0; pw < pooled_width_; ++pw) {
-            int hstart = ph * stride_h_ - pad_h_;
-            int wstart = pw * stride_w_ - pad_w_;
-            int hend = min(hstart + kernel_h_, height_);
-            int wend = min(wstart + kernel_w_, width_);
-            hstart = max(hstart, 0);
-            wstart = max(wstart, 0);
-            const int pool_index = ph * pooled_width_ + pw;
-            for (int h = hstart; h < hend; ++h) {
-              for (int w = wstart; w < wend; ++w) {
-                const int index = h * width_ + w;
-                if (bottom_data[index] > top_data[pool_index]) {
-                  top_data[pool_index] = bottom_data[index];
-                  if (use_top_mask) {
-                    top_mask[pool_index] = static_cast<Dtype>(index);
-                  } else {
-                    mask[pool_index] = index;
-                  }
-                }
-              }
-            }
-          }
-        }
-        // compute offset
-        bottom_data += bottom[0]->offset(0, 1);
-        top_data += top[0]->offset(0, 1);
-        if (use_top_mask) {
-          top_mask += top[0]->offset(0, 1);
-        } else {
-          mask += top[0]->offset(0, 1);
-        }
-      }
+      parallel_for(0, num_planes, boost::bind(
+          &PoolingLayer<Dtype>::template MaxPoolPlanes<int>, this,
+          bottom_data, top_data, max_idx_.mutable_cpu_data(), _1, _2), grain);
     }
     break;
   case PoolingParameter_PoolMethod_AVE:
-    for (int i = 0; i < top_count; ++i) {
-      top_data[i] = 0;
-    }
-    // The main loop
-    for (int n = 0; n < bottom[0]->num(); ++n) {
-      for (int c = 0; c < channels_; ++c) {
-        for (int ph = 0; ph < pooled_height_; ++ph) {
-          for (int pw = 0; pw < pooled_width_; ++pw) {
-            int hstart = ph * stride_h_ - pad_h_;
-            int wstart = pw * stride_w_ - pad_w_;
-            int hend = min(hstart + kernel_h_, height_ + pad_h_);
-            int wend = min(wstart + kernel_w_, width_ + pad_w_);
-            int pool_size = (hend - hstart) * (wend - wstart);
-            hstart = max(hstart, 0);
-            wstart = max(wstart, 0);
-            hend = min(hend, height_);
-            wend = min(wend, width_);
-            for (int h = hstart; h < hend; ++h) {
-              for (int w = wstart; w < wend; ++w) {
-                top_data[ph * pooled_width_ + pw] +=
-                    bottom_data[h * width_ + w];
-              }
-            }
-            top_data[ph * pooled_width_ + pw] /= pool_size;
-          }
-        }
-        // compute offset
-        bottom_data += bottom[0]->offset(0, 1);
-        top_data += top[0]->offset(0, 1);
-      }
-    }
+    parallel_for(0, num_planes, boost::bind(
+        &PoolingLayer<Dtype>::AvePoolPlanes, this, bottom_data, top_data,
+        _1, _2), grain);
     break;
   case PoolingParameter_PoolMethod_STOCHASTIC:
     NOT_IMPLEMENTED;
@@ -234,69 +372,29 @@ void PoolingLayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
   }
   const Dtype* top_diff = top[0]->cpu_diff();
   Dtype* bottom_diff = bottom[0]->mutable_cpu_diff();
+  const int num_planes = top[0]->num() * channels_;
+  const int grain = PlaneGrain(num_planes);
   // Different pooling methods. We explicitly do the switch outside the for
   // loop to save time, although this results in more codes.
   caffe_set(bottom[0]->count(), Dtype(0), bottom_diff);
   // We'll output the mask to top[1] if it's of size >1.
   const bool use_top_mask = top.size() > 1;
-  const int* mask = NULL;  // suppress warnings about uninitialized variables
-  const Dtype* top_mask = NULL;
   switch (this->layer_param_.pooling_param().pool()) {
   case PoolingParameter_PoolMethod_MAX:
-    // The main loop
     if (use_top_mask) {
-      top_mask = top[1]->cpu_data();
+      parallel_for(0, num_planes, boost::bind(
+          &PoolingLayer<Dtype>::template MaxUnpoolPlanes<Dtype>, this,
+          top_diff, top[1]->cpu_data(), bottom_diff, _1, _2), grain);
     } else {
-      mask = max_idx_.cpu_data();
-    }
-    for (int n = 0; n < top[0]->num(); ++n) {
-      for (int c = 0; c < channels_; ++c) {
-        for (int ph = 0; ph < pooled_height_; ++ph) {
-          for (int pw = 0; pw < pooled_width_; ++pw) {
-            const int index = ph * pooled_width_ + pw;
-            const int bottom_index =
-                use_top_mask ? top_mask[index] : mask[index];
-            bottom_diff[bottom_index] += top_diff[index];
-          }
-        }
-        bottom_diff += bottom[0]->offset(0, 1);
-        top_diff += top[0]->offset(0, 1);
-        if (use_top_mask) {
-          top_mask += top[0]->offset(0, 1);
-        } else {
-          mask += top[0]->offset(0, 1);
-        }
-      }
+      parallel_for(0, num_planes, boost::bind(
+          &PoolingLayer<Dtype>::template MaxUnpoolPlanes<int>, this,
+          top_diff, max_idx_.cpu_data(), bottom_diff, _1, _2), grain);
     }
     break;
   case PoolingParameter_PoolMethod_AVE:
-    // The main loop
-    for (int n = 0; n < top[0]->num(); ++n) {
-      for (int c = 0; c < channels_; ++c) {
-        for (int ph = 0; ph < pooled_height_; ++ph) {
-          for (int pw = 0; pw < pooled_width_; ++pw) {
-            int hstart = ph * stride_h_ - pad_h_;
-            int wstart = pw * stride_w_ - pad_w_;
-            int hend = min(hstart + kernel_h_, height_ + pad_h_);
-            int wend = min(wstart + kernel_w_, width_ + pad_w_);
-            int pool_size = (hend - hstart) * (wend - wstart);
-            hstart = max(hstart, 0);
-            wstart = max(wstart, 0);
-            hend = min(hend, height_);
-            wend = min(wend, width_);
-            for (int h = hstart; h < hend; ++h) {
-              for (int w = wstart; w < wend; ++w) {
-                bottom_diff[h * width_ + w] +=
-                  top_diff[ph * pooled_width_ + pw] / pool_size;
-              }
-            }
-          }
-        }
-        // offset
-        bottom_diff += bottom[0]->offset(0, 1);
-        top_diff += top[0]->offset(0, 1);
-      }
-    }
+    parallel_for(0, num_planes, boost::bind(
+        &PoolingLayer<Dtype>::AveUnpoolPlanes, this, top_diff, bottom_diff,
+        _1, _2), grain);
     break;
   case PoolingParameter_PoolMethod_STOCHASTIC:
     NOT_IMPLEMENTED;
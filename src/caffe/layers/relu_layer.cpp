@@ -1,10 +1,35 @@
+#include <boost/bind.hpp>
 #include <algorithm>
 #include <vector>
 
 #include "caffe/layers/relu_layer.hpp"
+#include "caffe/util/thread_pool.hpp"
 
 namespace caffe {
 
+// Elements per parallel_for chunk: enough to amortize handing the chunk to
+// another thread.
+static const int kReLUGrain = 16384;
+
+template <typename Dtype>
+static void relu_forward(const Dtype* bottom_data, Dtype* top_data,
+    const Dtype negative_slope, const int begin, const int end) {
+  for (int i = begin; i < end; ++i) {
+    top_data[i] = std::max(bottom_data[i], Dtype(0))
+        + negative_slope * std::min(bottom_data[i], Dtype(0));
+  }
+}
+
+template <typename Dtype>
+static void relu_backward(const Dtype* bottom_data, const Dtype* top_diff,
+    Dtype* bottom_diff, const Dtype negative_slope, const int begin,
+    const int end) {
+  for (int i = begin; i < end; ++i) {
+    bottom_diff[i] = top_diff[i] * ((bottom_data[i] > 0)
+        + negative_slope * (bottom_data[i] <= 0));
+  }
+}
+
 template <typename Dtype>
 void ReLULayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
     const vector<Blob<Dtype>*>& top) {
@@ -12,10 +37,8 @@ void ReLULayer<Dtype>::Forward_cpu(const vector<Blob<Dtype>*>& bottom,
   Dtype* top_data = top[0]->mutable_cpu_data();
   const int count = bottom[0]->count();
   Dtype negative_slope = this->layer_param_.relu_param().negative_slope();
-  for (int i = 0; i < count; ++i) {
-    top_data[i] = std::max(bottom_data[i], Dtype(0))
-        + negative_slope * std::min(bottom_data[i], Dtype(0));
-  }
+  parallel_for(0, count, boost::bind(&relu_forward<Dtype>, bottom_data,
+      top_data, negative_slope, _1, _2), kReLUGrain);
 }
 
 template <typename Dtype>
@@ -28,10 +51,8 @@ void ReLULayer<Dtype>::Backward_cpu(const vector<Blob<Dtype>*>& top,
     Dtype* bottom_diff = bottom[0]->mutable_cpu_diff();
     const int count = bottom[0]->count();
     Dtype negative_slope = this->layer_param_.relu_param().negative_slope();
-    for (int i = 0; i < count; ++i) {
-      bottom_diff[i] = top_diff[i] * ((bottom_data[i] > 0)
-          + negative_slope * (bottom_data[i] <= 0));
-    }
+    parallel_for(0, count, boost::bind(&relu_backward<Dtype>, bottom_data,
+        top_diff, bottom_diff, negative_slope, _1, _2), kReLUGrain);
   }
 }
 
@@ -0,0 +1,241 @@
+#include <vector>
+
+#include "caffe/layers/winograd_conv_layer.hpp"
+#include "caffe/util/math_functions.hpp"
+
+namespace caffe {
+
+// Transform matrices of F(2x2, 3x3) and F(4x4, 3x3): B^T is a x a, G is
+// a x 3 and A^T is m x a, all row-major, for input tiles of a = m + 2.
+static const double kBT2[] = {
+  1,  0, -1,  0,
+  0,  1,  1,  0,
+  0, -1,  1,  0,
+  0,  1,  0, -1 };
+static const double kG2[] = {
+  1,    0,   0,
+  0.5,  0.5, 0.5,
+  0.5, -0.5, 0.5,
+  0,    0,   1 };
+static const double kAT2[] = {
+  1,  1,  1,  0,
+  0,  1, -1, -1 };
+
+static const double kBT4[] = {
+  4,  0, -5,  0, 1, 0,
+  0, -4, -4,  1, 1, 0,
+  0,  4, -4, -1, 1, 0,
+  0, -2, -1,  2, 1, 0,
+  0,  2, -1, -2, 1, 0,
+  0,  4,  0, -5, 0, 1 };
+static const double kG4[] = {
+  1. / 4,   0,       0,
+  -1. / 6,  -1. / 6, -1. / 6,
+  -1. / 6,  1. / 6,  -1. / 6,
+  1. / 24,  1. / 12, 1. / 6,
+  1. / 24,  -1. / 12, 1. / 6,
+  0,        0,       1 };
+static const double kAT4[] = {
+  1,  1,  1,  1,  1, 0,
+  0,  1, -1,  2, -2, 0,
+  0,  1,  1,  4,  4, 0,
+  0,  1, -1,  8, -8, 1 };
+
+// out (rows x cols) = left (rows x inner) * in (inner x cols)
+//                     * right^T (right is cols x in_cols).
+template <typename Dtype>
+static void sandwich(const double* left, const Dtype* in, const double* right,
+    int rows, int inner, int in_cols, int cols, Dtype* out) {
+  Dtype tmp[6 * 6];
+  for (int i = 0; i < rows; ++i) {
+    for (int j = 0; j < in_cols; ++j) {
+      Dtype sum = 0;
+      for (int k = 0; k < inner; ++k) {
+        sum += left[i * inner + k] * in[k * in_cols + j];
+      }
+      tmp[i * in_cols + j] = sum;
+    }
+  }
+  for (int i = 0; i < rows; ++i) {
+    for (int j = 0; j < cols; ++j) {
+      Dtype sum = 0;
+      for (int k = 0; k < in_cols; ++k) {
+        sum += tmp[i * in_cols + k] * right[j * in_cols + k];
+      }
+      out[i * cols + j] = sum;
+    }
+  }
+}
+
+template <typename Dtype>
+void WinogradConvolutionLayer<Dtype>::LayerSetUp(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  ConvolutionLayer<Dtype>::LayerSetUp(bottom, top);
+  tile_ = this->layer_param_.convolution_param().winograd_tile();
+  CHECK(tile_ == 2 || tile_ == 4) << "winograd_tile must be 2 or 4.";
+  use_winograd_ = this->num_spatial_axes_ == 2;
+  for (int i = 0; use_winograd_ && i < this->num_spatial_axes_; ++i) {
+    use_winograd_ = this->kernel_shape_.cpu_data()[i] == 3 &&
+        this->stride_.cpu_data()[i] == 1 && this->dilation_.cpu_data()[i] == 1;
+  }
+  if (!use_winograd_) {
+    LOG(INFO) << "Layer " << this->layer_param_.name() << " is not 3x3, "
+        << "stride 1 2D convolution; falling back to the CAFFE engine.";
+    return;
+  }
+  const int a = tile_ + 2;
+  vector<int> weight_shape(3);
+  weight_shape[0] = a * a;
+  weight_shape[1] = this->num_output_;
+  weight_shape[2] = this->channels_ / this->group_;
+  transformed_weights_.Reshape(weight_shape);
+  transformed_from_.reset();
+}
+
+template <typename Dtype>
+void WinogradConvolutionLayer<Dtype>::Reshape(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  ConvolutionLayer<Dtype>::Reshape(bottom, top);
+  if (!use_winograd_) {
+    return;
+  }
+  tiles_h_ = (this->output_shape_[0] + tile_ - 1) / tile_;
+  tiles_w_ = (this->output_shape_[1] + tile_ - 1) / tile_;
+}
+
+template <typename Dtype>
+void WinogradConvolutionLayer<Dtype>::TransformWeights() {
+  const shared_ptr<SyncedMemory>& weights = this->blobs_[0]->data();
+  if (transformed_from_ == weights &&
+      transformed_version_ == weights->version()) {
+    return;
+  }
+  const int a = tile_ + 2;
+  const double* G = (tile_ == 2) ? kG2 : kG4;
+  const int count = this->blobs_[0]->count(0, 2);
+  const Dtype* weight = this->blobs_[0]->cpu_data();
+  Dtype* U = transformed_weights_.mutable_cpu_data();
+  Dtype u[6 * 6];
+  // blobs_[0] is (output channels x input channels per group) filters of
+  // 3 x 3, which is also the order of each of the a x a planes of U.
+  for (int i = 0; i < count; ++i) {
+    sandwich(G, weight + i * 9, G, a, 3, 3, a, u);
+    for (int xi = 0; xi < a * a; ++xi) {
+      U[xi * count + i] = u[xi];
+    }
+  }
+  transformed_from_ = weights;
+  transformed_version_ = weights->version();
+}
+
+template <typename Dtype>
+void WinogradConvolutionLayer<Dtype>::TransformInput(const Dtype* input,
+    Dtype* V) {
+  const int a = tile_ + 2;
+  const double* BT = (tile_ == 2) ? kBT2 : kBT4;
+  const int height = this->conv_input_shape_.cpu_data()[1];
+  const int width = this->conv_input_shape_.cpu_data()[2];
+  const int pad_h = this->pad_.cpu_data()[0];
+  const int pad_w = this->pad_.cpu_data()[1];
+  const int num_tiles = tiles_h_ * tiles_w_;
+  const int plane = this->channels_ * num_tiles;
+  Dtype d[6 * 6], v[6 * 6];
+  for (int c = 0; c < this->channels_; ++c) {
+    const Dtype* channel = input + c * height * width;
+    for (int th = 0; th < tiles_h_; ++th) {
+      for (int tw = 0; tw < tiles_w_; ++tw) {
+        const int h0 = th * tile_ - pad_h;
+        const int w0 = tw * tile_ - pad_w;
+        for (int i = 0; i < a; ++i) {
+          const int h = h0 + i;
+          for (int j = 0; j < a; ++j) {
+            const int w = w0 + j;
+            d[i * a + j] = (h >= 0 && h < height && w >= 0 && w < width) ?
+                channel[h * width + w] : Dtype(0);
+          }
+        }
+        sandwich(BT, d, BT, a, a, a, a, v);
+        Dtype* V_tile = V + c * num_tiles + th * tiles_w_ + tw;
+        for (int xi = 0; xi < a * a; ++xi) {
+          V_tile[xi * plane] = v[xi];
+        }
+      }
+    }
+  }
+}
+
+template <typename Dtype>
+void WinogradConvolutionLayer<Dtype>::TransformOutput(const Dtype* M,
+    Dtype* output) {
+  const int a = tile_ + 2;
+  const double* AT = (tile_ == 2) ? kAT2 : kAT4;
+  const int output_h = this->output_shape_[0];
+  const int output_w = this->output_shape_[1];
+  const int num_tiles = tiles_h_ * tiles_w_;
+  const int plane = this->num_output_ * num_tiles;
+  Dtype m[6 * 6], y[4 * 4];
+  for (int k = 0; k < this->num_output_; ++k) {
+    Dtype* channel = output + k * output_h * output_w;
+    for (int th = 0; th < tiles_h_; ++th) {
+      for (int tw = 0; tw < tiles_w_; ++tw) {
+        const Dtype* M_tile = M + k * num_tiles + th * tiles_w_ + tw;
+        for (int xi = 0; xi < a * a; ++xi) {
+          m[xi] = M_tile[xi * plane];
+        }
+        sandwich(AT, m, AT, tile_, a, a, tile_, y);
+        for (int i = 0; i < tile_ && th * tile_ + i < output_h; ++i) {
+          Dtype* row = channel + (th * tile_ + i) * output_w + tw * tile_;
+          for (int j = 0; j < tile_ && tw * tile_ + j < output_w; ++j) {
+            row[j] = y[i * tile_ + j];
+          }
+        }
+      }
+    }
+  }
+}
+
+template <typename Dtype>
+void WinogradConvolutionLayer<Dtype>::Forward_cpu(
+    const vector<Blob<Dtype>*>& bottom, const vector<Blob<Dtype>*>& top) {
+  if (!use_winograd_) {
+    ConvolutionLayer<Dtype>::Forward_cpu(bottom, top);
+    return;
+  }
+  TransformWeights();
+  const int a = tile_ + 2;
+  const int num_tiles = tiles_h_ * tiles_w_;
+  const int group_in = this->channels_ / this->group_;
+  const int group_out = this->num_output_ / this->group_;
+  const Dtype* U = transformed_weights_.cpu_data();
+  // V: (m + 2)^2 x input channels x tiles, and U V: (m + 2)^2 x output
+  // channels x tiles, both borrowed from the workspace.
+  Dtype* V = this->workspace_cpu(a * a * num_tiles *
+      (this->channels_ + this->num_output_));
+  Dtype* M = V + a * a * this->channels_ * num_tiles;
+  for (int i = 0; i < bottom.size(); ++i) {
+    const Dtype* bottom_data = bottom[i]->cpu_data();
+    Dtype* top_data = top[i]->mutable_cpu_data();
+    for (int n = 0; n < this->num_; ++n) {
+      TransformInput(bottom_data + n * this->bottom_dim_, V);
+      for (int xi = 0; xi < a * a; ++xi) {
+        for (int g = 0; g < this->group_; ++g) {
+          caffe_cpu_gemm<Dtype>(CblasNoTrans, CblasNoTrans, group_out,
+              num_tiles, group_in, (Dtype)1.,
+              U + (xi * this->num_output_ + g * group_out) * group_in,
+              V + (xi * this->channels_ + g * group_in) * num_tiles, (Dtype)0.,
+              M + (xi * this->num_output_ + g * group_out) * num_tiles);
+        }
+      }
+      TransformOutput(M, top_data + n * this->top_dim_);
+      if (this->bias_term_) {
+        this->forward_cpu_bias(top_data + n * this->top_dim_,
+            this->blobs_[1]->cpu_data());
+      }
+      this->forward_cpu_relu(top_data + n * this->top_dim_);
+    }
+  }
+}
+
+INSTANTIATE_CLASS(WinogradConvolutionLayer);
+
+}  // namespace caffe
@@ -279,10 +279,192 @@ void Net<Dtype>::Init(const NetParameter& in_param) {
     layer_names_index_[layer_names_[layer_id]] = layer_id;
   }
   ShareWeights();
+  if (param.share_activations()) {
+    ShareActivationMemory();
+  }
+  if (param.contiguous_params() && phase_ == TRAIN) {
+    if (Caffe::mode() == Caffe::CPU) {
+      FlattenParams();
+    } else {
+      LOG(WARNING) << "contiguous_params only applies in CPU mode.";
+    }
+  }
   debug_info_ = param.debug_info();
   LOG_IF(INFO, Caffe::root_solver()) << "Network initialization done.";
 }
 
+template <typename Dtype>
+void Net<Dtype>::ShareActivationMemory() {
+  for (int layer_id = 0; layer_id < layers_.size(); ++layer_id) {
+    if (layer_need_backward_[layer_id]) {
+      LOG(WARNING) << "Not sharing activation memory: layer "
+          << layer_names_[layer_id] << " needs backward computation.";
+      return;
+    }
+  }
+  // Tie the blobs that have to live together into one value each.
+  const int num_blobs = blobs_.size();
+  activation_buffers_.assign(num_blobs, shared_ptr<SyncedMemory>());
+  vector<int> value(num_blobs);
+  for (int blob_id = 0; blob_id < num_blobs; ++blob_id) {
+    value[blob_id] = blob_id;
+  }
+  for (int layer_id = 0; layer_id < layers_.size(); ++layer_id) {
+    if (!layers_[layer_id]->SharesBottomData()) { continue; }
+    const vector<int>& bottom_ids = bottom_id_vecs_[layer_id];
+    const vector<int>& top_ids = top_id_vecs_[layer_id];
+    vector<int> tied(bottom_ids);
+    tied.insert(tied.end(), top_ids.begin(), top_ids.end());
+    // Point every tied value at the smallest one among them.
+    int root = num_blobs;
+    for (int i = 0; i < tied.size(); ++i) {
+      root = std::min(root, value[tied[i]]);
+    }
+    for (int i = 0; i < tied.size(); ++i) {
+      const int old_value = value[tied[i]];
+      for (int blob_id = 0; blob_id < num_blobs; ++blob_id) {
+        if (value[blob_id] == old_value) { value[blob_id] = root; }
+      }
+    }
+  }
+  // Work out each value's lifetime [first, last] in layers, its size, and
+  // whether it has to keep its own memory.
+  vector<int> first(num_blobs, layers_.size());
+  vector<int> last(num_blobs, -1);
+  vector<size_t> bytes(num_blobs, 0);
+  vector<bool> pinned(num_blobs, false);
+  for (int i = 0; i < net_input_blob_indices_.size(); ++i) {
+    pinned[value[net_input_blob_indices_[i]]] = true;
+  }
+  for (int i = 0; i < net_output_blob_indices_.size(); ++i) {
+    pinned[value[net_output_blob_indices_[i]]] = true;
+  }
+  for (int layer_id = 0; layer_id < layers_.size(); ++layer_id) {
+    for (int i = 0; i < top_id_vecs_[layer_id].size(); ++i) {
+      const int v = value[top_id_vecs_[layer_id][i]];
+      first[v] = std::min(first[v], layer_id);
+      last[v] = std::max(last[v], layer_id);
+      if (bottom_id_vecs_[layer_id].empty()) { pinned[v] = true; }
+    }
+    for (int i = 0; i < bottom_id_vecs_[layer_id].size(); ++i) {
+      const int v = value[bottom_id_vecs_[layer_id][i]];
+      last[v] = std::max(last[v], layer_id);
+    }
+  }
+  size_t bytes_before = 0;
+  for (int blob_id = 0; blob_id < num_blobs; ++blob_id) {
+    const shared_ptr<SyncedMemory>& data = blobs_[blob_id]->data();
+    if (!data) {
+      pinned[value[blob_id]] = true;
+    } else {
+      // The blob's own size: once shared, data is the whole buffer.
+      bytes[value[blob_id]] = std::max(bytes[value[blob_id]],
+          blobs_[blob_id]->count() * sizeof(Dtype));
+    }
+  }
+  for (int v = 0; v < num_blobs; ++v) {
+    bytes_before += bytes[v];
+  }
+  // Greedily hand each value, in order of production, the free buffer that
+  // fits it most tightly (or else the largest free one, which then grows).
+  vector<size_t> buffer_bytes;
+  vector<int> buffer_free_after;
+  vector<int> buffer_of_value(num_blobs, -1);
+  for (int layer_id = 0; layer_id < layers_.size(); ++layer_id) {
+    for (int i = 0; i < top_id_vecs_[layer_id].size(); ++i) {
+      const int v = value[top_id_vecs_[layer_id][i]];
+      if (pinned[v] || first[v] != layer_id || buffer_of_value[v] >= 0) {
+        continue;
+      }
+      int best = -1;
+      for (int k = 0; k < buffer_bytes.size(); ++k) {
+        if (buffer_free_after[k] >= layer_id) { continue; }
+        if (best < 0) {
+          best = k;
+        } else if (buffer_bytes[k] >= bytes[v]) {
+          if (buffer_bytes[best] < bytes[v] ||
+              buffer_bytes[k] < buffer_bytes[best]) {
+            best = k;
+          }
+        } else if (buffer_bytes[k] > buffer_bytes[best]) {
+          best = k;
+        }
+      }
+      if (best < 0) {
+        best = buffer_bytes.size();
+        buffer_bytes.push_back(0);
+        buffer_free_after.push_back(-1);
+      }
+      buffer_bytes[best] = std::max(buffer_bytes[best], bytes[v]);
+      buffer_free_after[best] = last[v];
+      buffer_of_value[v] = best;
+    }
+  }
+  vector<shared_ptr<SyncedMemory> > buffers(buffer_bytes.size());
+  for (int k = 0; k < buffers.size(); ++k) {
+    buffers[k].reset(new SyncedMemory(buffer_bytes[k]));
+  }
+  for (int blob_id = 0; blob_id < num_blobs; ++blob_id) {
+    const int buffer = buffer_of_value[value[blob_id]];
+    if (buffer >= 0) {
+      blobs_[blob_id]->ShareDataMemory(buffers[buffer]);
+      activation_buffers_[blob_id] = buffers[buffer];
+    }
+  }
+  // The activations hold all their memory throughout a pass, so what the
+  // distinct buffers add up to is the peak.
+  set<SyncedMemory*> counted;
+  size_t bytes_after = 0;
+  for (int blob_id = 0; blob_id < num_blobs; ++blob_id) {
+    SyncedMemory* data = blobs_[blob_id]->data().get();
+    if (data && counted.insert(data).second) {
+      bytes_after += data->size();
+    }
+  }
+  LOG_IF(INFO, Caffe::root_solver())
+      << "Sharing activation memory: " << bytes_before << " bytes in "
+      << "separate blobs, a peak of " << bytes_after << " bytes with "
+      << buffers.size() << " shared buffers.";
+}
+
+template <typename Dtype>
+void Net<Dtype>::ReshareGrownActivations() {
+  for (int blob_id = 0; blob_id < activation_buffers_.size(); ++blob_id) {
+    if (activation_buffers_[blob_id] &&
+        blobs_[blob_id]->data() != activation_buffers_[blob_id]) {
+      LOG_IF(INFO, Caffe::root_solver()) << "Blob " << blob_names_[blob_id]
+          << " grew out of its shared activation memory; planning it again.";
+      ShareActivationMemory();
+      return;
+    }
+  }
+}
+
+template <typename Dtype>
+void Net<Dtype>::FlattenParams() {
+  int count = 0;
+  for (int i = 0; i < learnable_params_.size(); ++i) {
+    count += learnable_params_[i]->count();
+  }
+  if (count == 0) { return; }
+  flat_params_.reset(new Blob<Dtype>(vector<int>(1, count)));
+  Dtype* data = flat_params_->mutable_cpu_data();
+  Dtype* diff = flat_params_->mutable_cpu_diff();
+  for (int i = 0; i < learnable_params_.size(); ++i) {
+    Blob<Dtype>* param = learnable_params_[i];
+    caffe_copy(param->count(), param->cpu_data(), data);
+    caffe_copy(param->count(), param->cpu_diff(), diff);
+    // Params that share this one hold the same SyncedMemory, so they become
+    // views as well.
+    param->data()->set_cpu_data(data);
+    param->diff()->set_cpu_data(diff);
+    data += param->count();
+    diff += param->count();
+  }
+  LOG_IF(INFO, Caffe::root_solver()) << "Learnable params kept contiguous: "
+      << count << " values in " << learnable_params_.size() << " params.";
+}
+
 template <typename Dtype>
 void Net<Dtype>::FilterNet(const NetParameter& param,
     NetParameter* param_filtered) {
@@ -561,11 +743,56 @@ void Net<Dtype>::AppendParam(const NetParameter& param, const int layer_id,
   }
 }
 
+template <typename Dtype>
+void Net<Dtype>::set_profiling(const bool value) {
+  if (!value) {
+    profiler_.reset();
+    return;
+  }
+  vector<string> layer_types;
+  for (int i = 0; i < layers_.size(); ++i) {
+    layer_types.push_back(layers_[i]->type());
+  }
+  profiler_.reset(new Profiler(layer_names_, layer_types));
+}
+
+template <typename Dtype>
+void Net<Dtype>::EstimateForwardCost(int layer_id, double* flops,
+    double* bytes) const {
+  double bottom_count = 0, top_count = 0, param_count = 0;
+  for (int i = 0; i < bottom_vecs_[layer_id].size(); ++i) {
+    bottom_count += bottom_vecs_[layer_id][i]->count();
+  }
+  for (int i = 0; i < top_vecs_[layer_id].size(); ++i) {
+    top_count += top_vecs_[layer_id][i]->count();
+  }
+  const vector<shared_ptr<Blob<Dtype> > >& params = layers_[layer_id]->blobs();
+  for (int i = 0; i < params.size(); ++i) {
+    param_count += params[i]->count();
+  }
+  *bytes = (bottom_count + top_count + param_count) * sizeof(Dtype);
+  // A multiply-add per weight and output of layers that multiply matrices;
+  // one operation per output for everything else.
+  const string type = layers_[layer_id]->type();
+  if (params.size() > 0 && (type == "Convolution" || type == "InnerProduct")) {
+    *flops = 2 * top_count * params[0]->count(1);
+  } else if (params.size() > 0 && type == "Deconvolution") {
+    *flops = 2 * bottom_count * params[0]->count(1);
+  } else {
+    *flops = top_count;
+  }
+}
+
 template <typename Dtype>
 Dtype Net<Dtype>::ForwardFromTo(int start, int end) {
   CHECK_GE(start, 0);
   CHECK_LT(end, layers_.size());
   Dtype loss = 0;
+  // Blobs that grew in the previous pass are shared again before this one;
+  // nothing but net inputs and data layer tops is alive at its start.
+  if (start == 0) {
+    ReshareGrownActivations();
+  }
   if (debug_info_) {
     for (int i = 0; i < net_input_blobs_.size(); ++i) {
       InputDebugInfo(i);
@@ -573,7 +800,13 @@ Dtype Net<Dtype>::ForwardFromTo(int start, int end) {
   }
   for (int i = start; i <= end; ++i) {
     // LOG(ERROR) << "Forwarding " << layer_names_[i];
+    if (profiler_) { profiler_->LayerBegin(); }
     Dtype layer_loss = layers_[i]->Forward(bottom_vecs_[i], top_vecs_[i]);
+    if (profiler_) {
+      double flops, bytes;
+      EstimateForwardCost(i, &flops, &bytes);
+      profiler_->LayerEnd(i, true, flops, bytes);
+    }
     loss += layer_loss;
     if (debug_info_) { ForwardDebugInfo(i); }
   }
@@ -637,8 +870,10 @@ void Net<Dtype>::BackwardFromTo(int start, int end) {
   CHECK_LT(start, layers_.size());
   for (int i = start; i >= end; --i) {
     if (layer_need_backward_[i]) {
+      if (profiler_) { profiler_->LayerBegin(); }
       layers_[i]->Backward(
           top_vecs_[i], bottom_need_backward_[i], bottom_vecs_[i]);
+      if (profiler_) { profiler_->LayerEnd(i, false, 0, 0); }
       if (debug_info_) { BackwardDebugInfo(i); }
     }
   }
@@ -799,6 +1034,7 @@ void Net<Dtype>::Reshape() {
   for (int i = 0; i < layers_.size(); ++i) {
     layers_[i]->Reshape(bottom_vecs_[i], top_vecs_[i]);
   }
+  ReshareGrownActivations();
 }
 
 template <typename Dtype>
@@ -859,6 +1095,7 @@ void Net<Dtype>::CopyTrainedLayersFromBinaryProto(
 
 template <typename Dtype>
 void Net<Dtype>::CopyTrainedLayersFromHDF5(const string trained_filename) {
+  HDF5Lock lock;
   hid_t file_hid = H5Fopen(trained_filename.c_str(), H5F_ACC_RDONLY,
                            H5P_DEFAULT);
   CHECK_GE(file_hid, 0) << "Couldn't open " << trained_filename;
@@ -924,6 +1161,7 @@ void Net<Dtype>::ToProto(NetParameter* param, bool write_diff) const {
 
 template <typename Dtype>
 void Net<Dtype>::ToHDF5(const string& filename, bool write_diff) const {
+  HDF5Lock lock;
   hid_t file_hid = H5Fcreate(filename.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT,
       H5P_DEFAULT);
   CHECK_GE(file_hid, 0)
@@ -981,13 +1219,32 @@ void Net<Dtype>::ToHDF5(const string& filename, bool write_diff) const {
 
 template <typename Dtype>
 void Net<Dtype>::Update() {
+  if (flat_params_ && Caffe::mode() == Caffe::CPU) {
+    flat_params_->Update();
+    TouchParams();
+    return;
+  }
   for (int i = 0; i < learnable_params_.size(); ++i) {
     learnable_params_[i]->Update();
   }
 }
 
+template <typename Dtype>
+void Net<Dtype>::TouchParams() {
+  // The params are views of memory written behind their backs, so bump
+  // their versions for whatever is cached from them (e.g. Winograd filters).
+  for (int i = 0; i < learnable_params_.size(); ++i) {
+    learnable_params_[i]->mutable_cpu_data();
+  }
+}
+
 template <typename Dtype>
 void Net<Dtype>::ClearParamDiffs() {
+  if (flat_params_ && Caffe::mode() == Caffe::CPU) {
+    caffe_set(flat_params_->count(), static_cast<Dtype>(0),
+              flat_params_->mutable_cpu_diff());
+    return;
+  }
   for (int i = 0; i < learnable_params_.size(); ++i) {
     Blob<Dtype>* blob = learnable_params_[i];
     switch (Caffe::mode()) {
@@ -430,8 +430,121 @@ void P2PSync<Dtype>::run(const vector<int>& gpus) {
   }
 }
 
+template<typename Dtype>
+CPUSync<Dtype>::CPUSync(shared_ptr<Solver<Dtype> > root_solver,
+                        CPUSync<Dtype>* root)
+    : Params<Dtype>(root_solver),
+      root_(root),
+      syncs_(),
+      barrier_(),
+      rank_(root ? root->syncs_.size() : 0),
+      initial_iter_(root_solver->iter()),
+      solver_() {
+  CHECK_EQ(Caffe::mode(), Caffe::CPU) << "CPUSync only runs in CPU mode.";
+  if (root == NULL) {
+    solver_ = root_solver;
+  } else {
+    Caffe::set_root_solver(false);
+    solver_.reset(new WorkerSolver<Dtype>(root_solver->param(),
+        root_solver.get()));
+    Caffe::set_root_solver(true);
+    barrier_ = root->barrier_;
+  }
+  Net<Dtype>* net = solver_->net().get();
+  if (!net->flat_params()) {
+    net->FlattenParams();
+  }
+  CHECK(net->flat_params()) << "Nothing to train in parallel: the net has "
+      "no learnable params.";
+  CHECK_EQ(size_, net->flat_params()->count());
+  diff_ = net->flat_params()->mutable_cpu_diff();
+  if (root == NULL) {
+    data_ = net->flat_params()->mutable_cpu_data();
+  } else {
+    // Only the root updates the params, so the workers read its copy.
+    data_ = root->data_;
+    apply_buffers(net->learnable_params(), data_, size_, replace_cpu);
+  }
+  (root ? root : this)->syncs_.push_back(this);
+  solver_->add_callback(this);
+}
+
+template<typename Dtype>
+CPUSync<Dtype>::~CPUSync() {
+}
+
+template<typename Dtype>
+void CPUSync<Dtype>::InternalThreadEntry() {
+  CHECK(Caffe::root_solver());
+  Caffe::set_root_solver(false);
+  // See if there is a defined seed and reset random state if so, modulated
+  // by rank so that the workers don't all draw the same numbers.
+  if (solver_->param().random_seed() >= 0) {
+    Caffe::set_random_seed(solver_->param().random_seed() + rank_);
+  }
+  solver_->Step(solver_->param().max_iter() - initial_iter_);
+}
+
+template<typename Dtype>
+void CPUSync<Dtype>::on_start() {
+  // Wait for the root to have applied the previous update.
+  barrier_->wait();
+  if (root_) {
+    // The update went into the root's memory, so mark the views of it
+    // here as changed for anything cached from them.
+    solver_->net()->TouchParams();
+  }
+}
+
+template<typename Dtype>
+void CPUSync<Dtype>::on_gradients_ready() {
+  // Once every gradient is ready, each thread sums one slice of all of them
+  // into the root's diff, so the reduction is spread over all the threads.
+  barrier_->wait();
+  const vector<CPUSync<Dtype>*>& syncs = (root_ ? root_ : this)->syncs_;
+  const size_t count = syncs.size();
+  const size_t begin = size_ * rank_ / count;
+  const size_t end = size_ * (rank_ + 1) / count;
+  Dtype* dst = syncs[0]->diff_ + begin;
+  for (int i = 1; i < count; ++i) {
+    caffe_axpy<Dtype>(end - begin, 1, syncs[i]->diff_ + begin, dst);
+  }
+  // Loss functions divide gradients by the batch size, so to compensate
+  // for split batch, the sum is divided by the number of solvers.
+  caffe_scal<Dtype>(end - begin, Dtype(1) / count, dst);
+  // The root may only update once every slice is in.
+  barrier_->wait();
+}
+
+template<typename Dtype>
+void CPUSync<Dtype>::run(int workers) {
+  CHECK(root_ == NULL) << "Only the root CPUSync runs the workers.";
+  CHECK_EQ(Caffe::solver_count(), workers)
+      << "Set Caffe::solver_count before creating the root solver.";
+  barrier_.reset(new boost::barrier(workers));
+  vector<shared_ptr<CPUSync<Dtype> > > syncs(workers);
+  for (int i = 1; i < workers; ++i) {
+    syncs[i].reset(new CPUSync<Dtype>(solver_, this));
+  }
+
+  LOG(INFO)<< "Starting Optimization on " << workers << " CPU workers";
+
+  for (int i = 1; i < syncs.size(); ++i) {
+    syncs[i]->StartInternalThread();
+  }
+
+  // Run root solver on current thread
+  solver_->Solve();
+
+  for (int i = 1; i < syncs.size(); ++i) {
+    syncs[i]->StopInternalThread();
+  }
+  syncs_.resize(1);
+}
+
 INSTANTIATE_CLASS(Params);
 INSTANTIATE_CLASS(GPUParams);
 INSTANTIATE_CLASS(P2PSync);
+INSTANTIATE_CLASS(CPUSync);
 
 }  // namespace caffe
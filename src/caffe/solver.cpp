@@ -1,6 +1,7 @@
 #include <cstdio>
 
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "caffe/solver.hpp"
@@ -58,6 +59,18 @@ void Solver<Dtype>::Init(const SolverParameter& param) {
   if (Caffe::root_solver()) {
     InitTestNets();
     LOG(INFO) << "Solver scaffolding done.";
+    if (param_.profile_interval() > 0) {
+      net_->set_profiling(true);
+    }
+    if (param_.snapshot_async()) {
+      if (param_.snapshot_format() == SolverParameter_SnapshotFormat_HDF5) {
+        LOG(WARNING) << "snapshot_async only applies to BINARYPROTO "
+            "snapshots; HDF5 snapshots are written synchronously.";
+      } else {
+        snapshot_writer_.reset(
+            new SnapshotWriter(param_.snapshot_max_pending()));
+      }
+    }
   }
   iter_ = 0;
   current_step_ = 0;
@@ -265,6 +278,17 @@ void Solver<Dtype>::Step(int iters) {
     // the number of times the weights have been updated.
     ++iter_;
 
+    // Report the layer profile and start over if needed.
+    if (net_->profiler() && param_.profile_interval() > 0 &&
+        iter_ % param_.profile_interval() == 0) {
+      LOG(INFO) << "Layer profile up to iteration " << iter_ << ":\n"
+          << net_->profiler()->Summary();
+      const string trace_filename = SnapshotFilename(".trace.json");
+      net_->profiler()->WriteChromeTrace(trace_filename);
+      LOG(INFO) << "Wrote layer timeline to " << trace_filename;
+      net_->profiler()->Reset();
+    }
+
     SolverAction::Enum request = GetRequestedAction();
 
     // Save a snapshot if needed.
@@ -305,6 +329,9 @@ void Solver<Dtype>::Solve(const char* resume_file) {
       && (!param_.snapshot() || iter_ % param_.snapshot() != 0)) {
     Snapshot();
   }
+  if (snapshot_writer_) {
+    snapshot_writer_->Flush();
+  }
   if (requested_early_exit_) {
     LOG(INFO) << "Optimization stopped early.";
     return;
@@ -427,6 +454,10 @@ void Solver<Dtype>::Snapshot() {
   }
 
   SnapshotSolverState(model_filename);
+  if (snapshot_writer_) {
+    snapshot_writer_->Write(snapshot_files_);
+    snapshot_files_.clear();
+  }
 }
 
 template <typename Dtype>
@@ -457,12 +488,22 @@ template <typename Dtype>
 string Solver<Dtype>::SnapshotToBinaryProto() {
   string model_filename = SnapshotFilename(".caffemodel");
   LOG(INFO) << "Snapshotting to binary proto file " << model_filename;
-  NetParameter net_param;
-  net_->ToProto(&net_param, param_.snapshot_diff());
-  WriteProtoToBinaryFile(net_param, model_filename);
+  shared_ptr<NetParameter> net_param(new NetParameter());
+  net_->ToProto(net_param.get(), param_.snapshot_diff());
+  WriteProtoSnapshot(net_param, model_filename);
   return model_filename;
 }
 
+template <typename Dtype>
+void Solver<Dtype>::WriteProtoSnapshot(const shared_ptr<Message>& proto,
+    const string& filename) {
+  if (snapshot_writer_) {
+    snapshot_files_.push_back(std::make_pair(proto, filename));
+  } else {
+    WriteProtoToBinaryFile(*proto, filename);
+  }
+}
+
 template <typename Dtype>
 string Solver<Dtype>::SnapshotToHDF5() {
   string model_filename = SnapshotFilename(".caffemodel.h5");
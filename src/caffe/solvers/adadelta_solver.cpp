@@ -1,6 +1,8 @@
+#include <cmath>
 #include <vector>
 
 #include "caffe/sgd_solvers.hpp"
+#include "caffe/util/thread_pool.hpp"
 
 namespace caffe {
 
@@ -16,6 +18,31 @@ void AdaDeltaSolver<Dtype>::AdaDeltaPreSolve() {
   }
 }
 
+// One pass of the AdaDelta update over the elements [begin, end) of a
+// parameter, with the histories of gradients and of updates.
+template <typename Dtype>
+struct AdaDeltaUpdateCPU {
+  const Dtype* data;
+  Dtype* diff;
+  Dtype* history;
+  Dtype* update_history;
+  SGDGradient<Dtype> gradient;
+  Dtype momentum;
+  Dtype delta;
+  Dtype local_rate;
+
+  void operator()(const int begin, const int end) const {
+    for (int i = begin; i < end; ++i) {
+      Dtype g = gradient(data[i], diff[i]);
+      history[i] = (1 - momentum) * g * g + momentum * history[i];
+      g *= std::sqrt((update_history[i] + delta) / (history[i] + delta));
+      update_history[i] = (1 - momentum) * g * g
+          + momentum * update_history[i];
+      diff[i] = local_rate * g;
+    }
+  }
+};
+
 #ifndef CPU_ONLY
 template <typename Dtype>
 void adadelta_update_gpu(int N, Dtype* g, Dtype* h, Dtype* h2, Dtype momentum,
@@ -32,61 +59,13 @@ void AdaDeltaSolver<Dtype>::ComputeUpdateValue(int param_id, Dtype rate) {
   size_t update_history_offset = net_params.size();
   switch (Caffe::mode()) {
   case Caffe::CPU: {
-    // compute square of gradient in update
-    caffe_powx(net_params[param_id]->count(),
-        net_params[param_id]->cpu_diff(), Dtype(2),
-        this->update_[param_id]->mutable_cpu_data());
-
-    // update history of gradients
-    caffe_cpu_axpby(net_params[param_id]->count(), Dtype(1) - momentum,
-        this->update_[param_id]->cpu_data(), momentum,
-        this->history_[param_id]->mutable_cpu_data());
-
-    // add delta to history to guard against dividing by zero later
-    caffe_set(net_params[param_id]->count(), delta,
-        this->temp_[param_id]->mutable_cpu_data());
-
-    caffe_add(net_params[param_id]->count(),
-        this->temp_[param_id]->cpu_data(),
-        this->history_[update_history_offset + param_id]->cpu_data(),
-        this->update_[param_id]->mutable_cpu_data());
-
-    caffe_add(net_params[param_id]->count(),
-        this->temp_[param_id]->cpu_data(),
-        this->history_[param_id]->cpu_data(),
-        this->temp_[param_id]->mutable_cpu_data());
-
-    // divide history of updates by history of gradients
-    caffe_div(net_params[param_id]->count(),
-        this->update_[param_id]->cpu_data(),
-        this->temp_[param_id]->cpu_data(),
-        this->update_[param_id]->mutable_cpu_data());
-
-    // jointly compute the RMS of both for update and gradient history
-    caffe_powx(net_params[param_id]->count(),
-        this->update_[param_id]->cpu_data(), Dtype(0.5),
-        this->update_[param_id]->mutable_cpu_data());
-
-    // compute the update
-    caffe_mul(net_params[param_id]->count(),
-        net_params[param_id]->cpu_diff(),
-        this->update_[param_id]->cpu_data(),
-        net_params[param_id]->mutable_cpu_diff());
-
-    // compute square of update
-    caffe_powx(net_params[param_id]->count(),
-        net_params[param_id]->cpu_diff(), Dtype(2),
-        this->update_[param_id]->mutable_cpu_data());
-
-    // update history of updates
-    caffe_cpu_axpby(net_params[param_id]->count(), Dtype(1) - momentum,
-        this->update_[param_id]->cpu_data(), momentum,
-        this->history_[update_history_offset + param_id]->mutable_cpu_data());
-
-    // apply learning rate
-    caffe_cpu_scale(net_params[param_id]->count(), local_rate,
-        net_params[param_id]->cpu_diff(),
-        net_params[param_id]->mutable_cpu_diff());
+    const AdaDeltaUpdateCPU<Dtype> update = {
+        net_params[param_id]->cpu_data(),
+        net_params[param_id]->mutable_cpu_diff(),
+        this->history_[param_id]->mutable_cpu_data(),
+        this->history_[update_history_offset + param_id]->mutable_cpu_data(),
+        this->CPUGradient(param_id), momentum, delta, local_rate };
+    parallel_for(0, net_params[param_id]->count(), update, kSGDUpdateGrain);
     break;
   }
   case Caffe::GPU: {
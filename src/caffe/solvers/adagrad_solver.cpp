@@ -1,9 +1,31 @@
+#include <cmath>
 #include <vector>
 
 #include "caffe/sgd_solvers.hpp"
+#include "caffe/util/thread_pool.hpp"
 
 namespace caffe {
 
+// One pass of the AdaGrad update over the elements [begin, end) of a
+// parameter.
+template <typename Dtype>
+struct AdaGradUpdateCPU {
+  const Dtype* data;
+  Dtype* diff;
+  Dtype* history;
+  SGDGradient<Dtype> gradient;
+  Dtype delta;
+  Dtype local_rate;
+
+  void operator()(const int begin, const int end) const {
+    for (int i = begin; i < end; ++i) {
+      const Dtype g = gradient(data[i], diff[i]);
+      history[i] += g * g;
+      diff[i] = local_rate * g / (std::sqrt(history[i]) + delta);
+    }
+  }
+};
+
 #ifndef CPU_ONLY
 template <typename Dtype>
 void adagrad_update_gpu(int N, Dtype* g, Dtype* h, Dtype delta,
@@ -19,34 +41,12 @@ void AdaGradSolver<Dtype>::ComputeUpdateValue(int param_id, Dtype rate) {
   Dtype local_rate = rate * net_params_lr[param_id];
   switch (Caffe::mode()) {
   case Caffe::CPU: {
-    // compute square of gradient in update
-    caffe_powx(net_params[param_id]->count(),
-        net_params[param_id]->cpu_diff(), Dtype(2),
-        this->update_[param_id]->mutable_cpu_data());
-
-    // update history
-    caffe_add(net_params[param_id]->count(),
-        this->update_[param_id]->cpu_data(),
-        this->history_[param_id]->cpu_data(),
-        this->history_[param_id]->mutable_cpu_data());
-
-    // prepare update
-    caffe_powx(net_params[param_id]->count(),
-              this->history_[param_id]->cpu_data(), Dtype(0.5),
-              this->update_[param_id]->mutable_cpu_data());
-
-    caffe_add_scalar(net_params[param_id]->count(),
-              delta, this->update_[param_id]->mutable_cpu_data());
-
-    caffe_div(net_params[param_id]->count(),
-              net_params[param_id]->cpu_diff(),
-              this->update_[param_id]->cpu_data(),
-              this->update_[param_id]->mutable_cpu_data());
-
-    // scale and copy
-    caffe_cpu_axpby(net_params[param_id]->count(), local_rate,
-        this->update_[param_id]->cpu_data(), Dtype(0),
-        net_params[param_id]->mutable_cpu_diff());
+    const AdaGradUpdateCPU<Dtype> update = {
+        net_params[param_id]->cpu_data(),
+        net_params[param_id]->mutable_cpu_diff(),
+        this->history_[param_id]->mutable_cpu_data(),
+        this->CPUGradient(param_id), delta, local_rate };
+    parallel_for(0, net_params[param_id]->count(), update, kSGDUpdateGrain);
     break;
   }
   case Caffe::GPU: {
@@ -1,6 +1,8 @@
+#include <cmath>
 #include <vector>
 
 #include "caffe/sgd_solvers.hpp"
+#include "caffe/util/thread_pool.hpp"
 
 namespace caffe {
 
@@ -16,6 +18,30 @@ void AdamSolver<Dtype>::AdamPreSolve() {
   }
 }
 
+// One pass of the Adam update over the elements [begin, end) of a
+// parameter, with its first and second moment estimates m and v.
+template <typename Dtype>
+struct AdamUpdateCPU {
+  const Dtype* data;
+  Dtype* diff;
+  Dtype* m;
+  Dtype* v;
+  SGDGradient<Dtype> gradient;
+  Dtype beta1;
+  Dtype beta2;
+  Dtype eps_hat;
+  Dtype corrected_local_rate;
+
+  void operator()(const int begin, const int end) const {
+    for (int i = begin; i < end; ++i) {
+      const Dtype g = gradient(data[i], diff[i]);
+      m[i] = (1 - beta1) * g + beta1 * m[i];
+      v[i] = (1 - beta2) * g * g + beta2 * v[i];
+      diff[i] = corrected_local_rate * m[i] / (std::sqrt(v[i]) + eps_hat);
+    }
+  }
+};
+
 #ifndef CPU_ONLY
 template <typename Dtype>
 void adam_update_gpu(int N, Dtype* g, Dtype* m, Dtype* v, Dtype beta1,
@@ -34,7 +60,6 @@ void AdamSolver<Dtype>::ComputeUpdateValue(int param_id, Dtype rate) {
   size_t update_history_offset = net_params.size();
   Blob<Dtype>* val_m = this->history_[param_id].get();
   Blob<Dtype>* val_v = this->history_[param_id + update_history_offset].get();
-  Blob<Dtype>* val_t = this->temp_[param_id].get();
 
   const int t = this->iter_ + 1;
   const Dtype correction = std::sqrt(Dtype(1) - pow(beta2, t)) /
@@ -44,33 +69,13 @@ void AdamSolver<Dtype>::ComputeUpdateValue(int param_id, Dtype rate) {
 
   switch (Caffe::mode()) {
     case Caffe::CPU: {
-    // update m <- \beta_1 m_{t-1} + (1-\beta_1)g_t
-    caffe_cpu_axpby(N, Dtype(1)-beta1,
-        net_params[param_id]->cpu_diff(), beta1,
-        val_m->mutable_cpu_data());
-
-    // update v <- \beta_2 m_{t-1} + (1-\beta_2)g_t^2
-    caffe_mul(N,
-        net_params[param_id]->cpu_diff(),
-        net_params[param_id]->cpu_diff(),
-    val_t->mutable_cpu_data());
-    caffe_cpu_axpby(N, Dtype(1)-beta2,
-        val_t->cpu_data(), beta2,
-        val_v->mutable_cpu_data());
-
-    // set update
-    caffe_powx(N,
-        val_v->cpu_data(), Dtype(0.5),
-        val_t->mutable_cpu_data());
-    caffe_add_scalar(N, eps_hat, val_t->mutable_cpu_data());
-    caffe_div(N,
-        val_m->cpu_data(),
-        val_t->cpu_data(),
-        val_t->mutable_cpu_data());
-
-    caffe_cpu_scale(N, local_rate*correction,
-        val_t->cpu_data(),
-        net_params[param_id]->mutable_cpu_diff());
+    const AdamUpdateCPU<Dtype> update = {
+        net_params[param_id]->cpu_data(),
+        net_params[param_id]->mutable_cpu_diff(),
+        val_m->mutable_cpu_data(), val_v->mutable_cpu_data(),
+        this->CPUGradient(param_id), beta1, beta2, eps_hat,
+        local_rate * correction };
+    parallel_for(0, N, update, kSGDUpdateGrain);
     break;
   }
   case Caffe::GPU: {
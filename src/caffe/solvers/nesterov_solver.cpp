@@ -1,9 +1,32 @@
+#include <cmath>
 #include <vector>
 
 #include "caffe/sgd_solvers.hpp"
+#include "caffe/util/thread_pool.hpp"
 
 namespace caffe {
 
+// One pass of the Nesterov update over the elements [begin, end) of a
+// parameter: step back to where the momentum started, then over step.
+template <typename Dtype>
+struct NesterovUpdateCPU {
+  const Dtype* data;
+  Dtype* diff;
+  Dtype* history;
+  SGDGradient<Dtype> gradient;
+  Dtype momentum;
+  Dtype local_rate;
+
+  void operator()(const int begin, const int end) const {
+    for (int i = begin; i < end; ++i) {
+      const Dtype history_old = history[i];
+      history[i] = momentum * history_old
+          + local_rate * gradient(data[i], diff[i]);
+      diff[i] = (1 + momentum) * history[i] - momentum * history_old;
+    }
+  }
+};
+
 #ifndef CPU_ONLY
 template <typename Dtype>
 void nesterov_update_gpu(int N, Dtype* g, Dtype* h, Dtype momentum,
@@ -19,25 +42,12 @@ void NesterovSolver<Dtype>::ComputeUpdateValue(int param_id, Dtype rate) {
   Dtype local_rate = rate * net_params_lr[param_id];
   switch (Caffe::mode()) {
   case Caffe::CPU: {
-    // save history momentum for stepping back
-    caffe_copy(net_params[param_id]->count(),
-        this->history_[param_id]->cpu_data(),
-        this->update_[param_id]->mutable_cpu_data());
-
-    // update history
-    caffe_cpu_axpby(net_params[param_id]->count(), local_rate,
-              net_params[param_id]->cpu_diff(), momentum,
-              this->history_[param_id]->mutable_cpu_data());
-
-    // compute update: step back then over step
-    caffe_cpu_axpby(net_params[param_id]->count(), Dtype(1) + momentum,
-        this->history_[param_id]->cpu_data(), -momentum,
-        this->update_[param_id]->mutable_cpu_data());
-
-    // copy
-    caffe_copy(net_params[param_id]->count(),
-        this->update_[param_id]->cpu_data(),
-        net_params[param_id]->mutable_cpu_diff());
+    const NesterovUpdateCPU<Dtype> update = {
+        net_params[param_id]->cpu_data(),
+        net_params[param_id]->mutable_cpu_diff(),
+        this->history_[param_id]->mutable_cpu_data(),
+        this->CPUGradient(param_id), momentum, local_rate };
+    parallel_for(0, net_params[param_id]->count(), update, kSGDUpdateGrain);
     break;
   }
   case Caffe::GPU: {
@@ -4,6 +4,7 @@
 #include "caffe/sgd_solvers.hpp"
 #include "caffe/util/hdf5.hpp"
 #include "caffe/util/io.hpp"
+#include "caffe/util/thread_pool.hpp"
 #include "caffe/util/upgrade_proto.hpp"
 
 namespace caffe {
@@ -81,7 +82,11 @@ template <typename Dtype>
 void SGDSolver<Dtype>::ClipGradients() {
   const Dtype clip_gradients = this->param_.clip_gradients();
   if (clip_gradients < 0) { return; }
-  const vector<Blob<Dtype>*>& net_params = this->net_->learnable_params();
+  // With contiguous params, all the diffs are one blob.
+  vector<Blob<Dtype>*> net_params = this->net_->learnable_params();
+  if (this->net_->flat_params() && Caffe::mode() == Caffe::CPU) {
+    net_params.assign(1, this->net_->flat_params().get());
+  }
   Dtype sumsq_diff = 0;
   for (int i = 0; i < net_params.size(); ++i) {
     sumsq_diff += net_params[i]->sumsq_diff();
@@ -108,8 +113,12 @@ void SGDSolver<Dtype>::ApplyUpdate() {
   ClipGradients();
   for (int param_id = 0; param_id < this->net_->learnable_params().size();
        ++param_id) {
-    Normalize(param_id);
-    Regularize(param_id);
+    // On the CPU, ComputeUpdateValue normalizes and regularizes in its own
+    // pass over the parameter, through CPUGradient.
+    if (Caffe::mode() != Caffe::CPU) {
+      Normalize(param_id);
+      Regularize(param_id);
+    }
     ComputeUpdateValue(param_id, rate);
   }
   this->net_->Update();
@@ -203,6 +212,38 @@ void SGDSolver<Dtype>::Regularize(int param_id) {
   }
 }
 
+template <typename Dtype>
+SGDGradient<Dtype> SGDSolver<Dtype>::CPUGradient(int param_id) {
+  const string& regularization_type = this->param_.regularization_type();
+  SGDGradient<Dtype> gradient;
+  gradient.scale = Dtype(1) / this->param_.iter_size();
+  gradient.decay = this->param_.weight_decay() *
+      this->net_->params_weight_decay()[param_id];
+  gradient.l1 = regularization_type == "L1";
+  if (gradient.decay && !gradient.l1 && regularization_type != "L2") {
+    LOG(FATAL) << "Unknown regularization type: " << regularization_type;
+  }
+  return gradient;
+}
+
+// One pass of the SGD update over the elements [begin, end) of a parameter.
+template <typename Dtype>
+struct SGDUpdateCPU {
+  const Dtype* data;
+  Dtype* diff;
+  Dtype* history;
+  SGDGradient<Dtype> gradient;
+  Dtype momentum;
+  Dtype local_rate;
+
+  void operator()(const int begin, const int end) const {
+    for (int i = begin; i < end; ++i) {
+      diff[i] = history[i] = momentum * history[i]
+          + local_rate * gradient(data[i], diff[i]);
+    }
+  }
+};
+
 #ifndef CPU_ONLY
 template <typename Dtype>
 void sgd_update_gpu(int N, Dtype* g, Dtype* h, Dtype momentum,
@@ -218,12 +259,11 @@ void SGDSolver<Dtype>::ComputeUpdateValue(int param_id, Dtype rate) {
   // Compute the update to history, then copy it to the parameter diff.
   switch (Caffe::mode()) {
   case Caffe::CPU: {
-    caffe_cpu_axpby(net_params[param_id]->count(), local_rate,
-              net_params[param_id]->cpu_diff(), momentum,
-              history_[param_id]->mutable_cpu_data());
-    caffe_copy(net_params[param_id]->count(),
-        history_[param_id]->cpu_data(),
-        net_params[param_id]->mutable_cpu_diff());
+    const SGDUpdateCPU<Dtype> update = { net_params[param_id]->cpu_data(),
+        net_params[param_id]->mutable_cpu_diff(),
+        history_[param_id]->mutable_cpu_data(), CPUGradient(param_id),
+        momentum, local_rate };
+    parallel_for(0, net_params[param_id]->count(), update, kSGDUpdateGrain);
     break;
   }
   case Caffe::GPU: {
@@ -259,20 +299,20 @@ void SGDSolver<Dtype>::SnapshotSolverState(const string& model_filename) {
 template <typename Dtype>
 void SGDSolver<Dtype>::SnapshotSolverStateToBinaryProto(
     const string& model_filename) {
-  SolverState state;
-  state.set_iter(this->iter_);
-  state.set_learned_net(model_filename);
-  state.set_current_step(this->current_step_);
-  state.clear_history();
+  shared_ptr<SolverState> state(new SolverState());
+  state->set_iter(this->iter_);
+  state->set_learned_net(model_filename);
+  state->set_current_step(this->current_step_);
+  state->clear_history();
   for (int i = 0; i < history_.size(); ++i) {
     // Add history
-    BlobProto* history_blob = state.add_history();
+    BlobProto* history_blob = state->add_history();
     history_[i]->ToProto(history_blob);
   }
   string snapshot_filename = Solver<Dtype>::SnapshotFilename(".solverstate");
   LOG(INFO)
     << "Snapshotting solver state to binary proto file " << snapshot_filename;
-  WriteProtoToBinaryFile(state, snapshot_filename.c_str());
+  this->WriteProtoSnapshot(state, snapshot_filename);
 }
 
 template <typename Dtype>
@@ -281,6 +321,7 @@ void SGDSolver<Dtype>::SnapshotSolverStateToHDF5(
   string snapshot_filename =
       Solver<Dtype>::SnapshotFilename(".solverstate.h5");
   LOG(INFO) << "Snapshotting solver state to HDF5 file " << snapshot_filename;
+  HDF5Lock lock;
   hid_t file_hid = H5Fcreate(snapshot_filename.c_str(), H5F_ACC_TRUNC,
       H5P_DEFAULT, H5P_DEFAULT);
   CHECK_GE(file_hid, 0)
@@ -323,6 +364,7 @@ void SGDSolver<Dtype>::RestoreSolverStateFromBinaryProto(
 
 template <typename Dtype>
 void SGDSolver<Dtype>::RestoreSolverStateFromHDF5(const string& state_file) {
+  HDF5Lock lock;
   hid_t file_hid = H5Fopen(state_file.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
   CHECK_GE(file_hid, 0) << "Couldn't open solver state file " << state_file;
   this->iter_ = hdf5_load_int(file_hid, "iter");
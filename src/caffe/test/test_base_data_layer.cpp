@@ -0,0 +1,144 @@
+#include <boost/thread.hpp>
+#include <algorithm>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "caffe/blob.hpp"
+#include "caffe/common.hpp"
+#include "caffe/layers/base_data_layer.hpp"
+#include "caffe/proto/caffe.pb.h"
+#include "caffe/util/blocking_queue.hpp"
+
+#include "caffe/test/test_caffe_main.hpp"
+
+namespace caffe {
+
+// Loads batches of one item numbered in order, each once the test releases
+// it, so that the test decides when Forward finds a batch ready.
+template <typename Dtype>
+class GatedDataLayer : public BasePrefetchingDataLayer<Dtype> {
+ public:
+  explicit GatedDataLayer(const LayerParameter& param)
+      : BasePrefetchingDataLayer<Dtype>(param), next_(0) {}
+  virtual ~GatedDataLayer() { this->StopInternalThread(); }
+  virtual void DataLayerSetUp(const vector<Blob<Dtype>*>& bottom,
+      const vector<Blob<Dtype>*>& top) {
+    vector<int> shape(1, 1);
+    top[0]->Reshape(shape);
+    top[1]->Reshape(shape);
+    for (int i = 0; i < this->prefetch_.size(); ++i) {
+      this->prefetch_[i]->data_.Reshape(shape);
+      this->prefetch_[i]->label_.Reshape(shape);
+    }
+  }
+  virtual inline const char* type() const { return "GatedData"; }
+
+  // Lets the prefetch thread load count more batches.
+  void Release(int count) {
+    for (int i = 0; i < count; ++i) {
+      released_.push(0);
+    }
+  }
+  // Waits until count batches are ready for Forward.
+  void WaitForReady(int count) {
+    while (this->prefetch_full_.size() < count) {
+      boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+    }
+  }
+
+ protected:
+  virtual void load_batch(Batch<Dtype>* batch) {
+    released_.pop();
+    batch->data_.mutable_cpu_data()[0] = next_;
+    batch->label_.mutable_cpu_data()[0] = next_;
+    ++next_;
+  }
+
+  BlockingQueue<int> released_;
+  int next_;
+};
+
+template <typename Dtype>
+class BaseDataLayerTest : public CPUDeviceTest<Dtype> {
+ protected:
+  BaseDataLayerTest()
+      : blob_top_data_(new Blob<Dtype>()),
+        blob_top_label_(new Blob<Dtype>()) {
+    blob_top_vec_.push_back(blob_top_data_);
+    blob_top_vec_.push_back(blob_top_label_);
+  }
+  virtual ~BaseDataLayerTest() {
+    delete blob_top_data_;
+    delete blob_top_label_;
+  }
+
+  static void ReleaseLater(GatedDataLayer<Dtype>* layer) {
+    boost::this_thread::sleep(boost::posix_time::milliseconds(20));
+    layer->Release(1);
+  }
+
+  // Runs Forward when no batch is ready, so that it has to wait.
+  void ForwardWaiting(GatedDataLayer<Dtype>* layer) {
+    boost::thread release(&BaseDataLayerTest::ReleaseLater, layer);
+    layer->Forward(blob_bottom_vec_, blob_top_vec_);
+    release.join();
+  }
+
+  Blob<Dtype>* const blob_top_data_;
+  Blob<Dtype>* const blob_top_label_;
+  vector<Blob<Dtype>*> blob_bottom_vec_;
+  vector<Blob<Dtype>*> blob_top_vec_;
+};
+
+TYPED_TEST_CASE(BaseDataLayerTest, TestDtypes);
+
+TYPED_TEST(BaseDataLayerTest, TestPrefetchCount) {
+  LayerParameter param;
+  param.mutable_data_param()->set_prefetch(2);
+  GatedDataLayer<TypeParam> layer(param);
+  layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  EXPECT_EQ(layer.prefetch_count(), 2);
+  layer.Release(2);
+  layer.WaitForReady(2);
+  for (int i = 0; i < 2; ++i) {
+    layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+    EXPECT_EQ(this->blob_top_label_->cpu_data()[0], i);
+  }
+  this->ForwardWaiting(&layer);
+  EXPECT_EQ(this->blob_top_label_->cpu_data()[0], 2);
+  EXPECT_EQ(layer.forward_count(), 3);
+  EXPECT_EQ(layer.wait_count(), 1);
+  EXPECT_GT(layer.wait_ms(), 0);
+  // Without max_prefetch the queue keeps its size.
+  EXPECT_EQ(layer.prefetch_count(), 2);
+}
+
+TYPED_TEST(BaseDataLayerTest, TestAdaptivePrefetch) {
+  LayerParameter param;
+  param.mutable_data_param()->set_prefetch(1);
+  param.mutable_data_param()->set_max_prefetch(3);
+  GatedDataLayer<TypeParam> layer(param);
+  layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  // Waiting for the first batch doesn't count against the queue.
+  this->ForwardWaiting(&layer);
+  EXPECT_EQ(layer.prefetch_count(), 1);
+  // Each later wait adds a batch, up to max_prefetch.
+  for (int i = 1; i < 4; ++i) {
+    this->ForwardWaiting(&layer);
+    EXPECT_EQ(this->blob_top_label_->cpu_data()[0], i);
+    EXPECT_EQ(layer.prefetch_count(), std::min(i + 1, 3));
+  }
+  EXPECT_EQ(layer.wait_count(), 4);
+  // The added batches are filled ahead of Forward.
+  layer.Release(3);
+  layer.WaitForReady(3);
+  for (int i = 4; i < 7; ++i) {
+    layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+    EXPECT_EQ(this->blob_top_label_->cpu_data()[0], i);
+  }
+  EXPECT_EQ(layer.forward_count(), 7);
+  EXPECT_EQ(layer.wait_count(), 4);
+}
+
+}  // namespace caffe
@@ -0,0 +1,102 @@
+#include <boost/thread.hpp>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "caffe/common.hpp"
+#include "caffe/util/bounded_queue.hpp"
+
+#include "caffe/test/test_caffe_main.hpp"
+
+namespace caffe {
+
+class BoundedQueueTest : public ::testing::Test {
+ protected:
+  // Pushes count items numbered from first.
+  static void Produce(BoundedQueue<int>* queue, int first, int count) {
+    for (int i = 0; i < count; ++i) {
+      queue->push(first + i);
+    }
+  }
+
+  // Pops count items, and counts each of them in seen.
+  static void Consume(BoundedQueue<int>* queue, int count,
+      vector<int>* seen) {
+    for (int i = 0; i < count; ++i) {
+      ++(*seen)[queue->pop()];
+    }
+  }
+
+  static void PopOne(BoundedQueue<int>* queue) {
+    queue->pop();
+  }
+};
+
+TEST_F(BoundedQueueTest, TestFirstInFirstOut) {
+  BoundedQueue<int> queue(3);
+  EXPECT_EQ(queue.capacity(), 4);
+  int item;
+  EXPECT_FALSE(queue.try_pop(&item));
+  EXPECT_FALSE(queue.try_peek(&item));
+  // Several laps around the ring.
+  for (int lap = 0; lap < 3; ++lap) {
+    for (int i = 0; i < 4; ++i) {
+      EXPECT_TRUE(queue.try_push(lap * 4 + i));
+    }
+    EXPECT_FALSE(queue.try_push(-1));
+    EXPECT_EQ(queue.size(), 4);
+    EXPECT_EQ(queue.peek(), lap * 4);
+    for (int i = 0; i < 4; ++i) {
+      EXPECT_EQ(queue.pop(), lap * 4 + i);
+    }
+    EXPECT_EQ(queue.size(), 0);
+  }
+}
+
+TEST_F(BoundedQueueTest, TestBlocking) {
+  BoundedQueue<int> queue(1);
+  // The consumer has to wait for every item, and the producer for room.
+  vector<int> seen(1000, 0);
+  boost::thread consumer(&BoundedQueueTest::Consume, &queue, 1000, &seen);
+  Produce(&queue, 0, 1000);
+  consumer.join();
+  for (int i = 0; i < seen.size(); ++i) {
+    EXPECT_EQ(seen[i], 1) << "item " << i;
+  }
+}
+
+TEST_F(BoundedQueueTest, TestManyProducersAndConsumers) {
+  const int kThreads = 4;
+  const int kItems = 10000;
+  BoundedQueue<int> queue(16);
+  vector<vector<int> > seen(kThreads, vector<int>(kThreads * kItems, 0));
+  boost::thread_group threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.create_thread(boost::bind(&BoundedQueueTest::Consume, &queue,
+        kItems, &seen[i]));
+    threads.create_thread(boost::bind(&BoundedQueueTest::Produce, &queue,
+        i * kItems, kItems));
+  }
+  threads.join_all();
+  for (int item = 0; item < kThreads * kItems; ++item) {
+    int count = 0;
+    for (int i = 0; i < kThreads; ++i) {
+      count += seen[i][item];
+    }
+    EXPECT_EQ(count, 1) << "item " << item;
+  }
+  EXPECT_EQ(queue.size(), 0);
+}
+
+TEST_F(BoundedQueueTest, TestInterruptWaitingPop) {
+  BoundedQueue<int> queue(2);
+  boost::thread consumer(&BoundedQueueTest::PopOne, &queue);
+  boost::this_thread::sleep(boost::posix_time::milliseconds(20));
+  consumer.interrupt();
+  consumer.join();
+  // The queue still works after a waiter went away.
+  queue.push(7);
+  EXPECT_EQ(queue.pop(), 7);
+}
+
+}  // namespace caffe
@@ -42,6 +42,36 @@ TEST_F(CommonTest, TestRandSeedCPU) {
   }
 }
 
+TEST_F(CommonTest, TestWorkspaceOnlyGrows) {
+  Caffe::release_workspace();
+  SyncedMemory* workspace = Caffe::cpu_workspace(100);
+  EXPECT_EQ(workspace->size(), 100);
+  void* data = workspace->mutable_cpu_data();
+  // Smaller requests are served by the same memory.
+  workspace = Caffe::cpu_workspace(10);
+  EXPECT_EQ(workspace->size(), 100);
+  EXPECT_EQ(workspace->mutable_cpu_data(), data);
+  workspace = Caffe::cpu_workspace(1000);
+  EXPECT_EQ(workspace->size(), 1000);
+  EXPECT_EQ(Caffe::cpu_workspace(100), workspace);
+  Caffe::release_workspace();
+}
+
+#ifndef CPU_ONLY
+TEST_F(CommonTest, TestWorkspaceSeparatesDevices) {
+  Caffe::release_workspace();
+  // Host and device scratch never share a buffer, so neither is synced.
+  SyncedMemory* cpu_workspace = Caffe::cpu_workspace(100);
+  SyncedMemory* gpu_workspace = Caffe::gpu_workspace(100);
+  EXPECT_NE(cpu_workspace, gpu_workspace);
+  cpu_workspace->mutable_cpu_data();
+  gpu_workspace->mutable_gpu_data();
+  EXPECT_EQ(cpu_workspace->head(), SyncedMemory::HEAD_AT_CPU);
+  EXPECT_EQ(gpu_workspace->head(), SyncedMemory::HEAD_AT_GPU);
+  Caffe::release_workspace();
+}
+#endif
+
 #ifndef CPU_ONLY  // GPU Caffe singleton test.
 
 TEST_F(CommonTest, TestRandSeedGPU) {
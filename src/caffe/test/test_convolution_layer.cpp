@@ -6,6 +6,8 @@
 #include "caffe/common.hpp"
 #include "caffe/filler.hpp"
 #include "caffe/layers/conv_layer.hpp"
+#include "caffe/layers/direct_conv_layer.hpp"
+#include "caffe/layers/winograd_conv_layer.hpp"
 
 #ifdef USE_CUDNN
 #include "caffe/layers/cudnn_conv_layer.hpp"
@@ -811,6 +813,212 @@ TYPED_TEST(ConvolutionLayerTest, TestGradientGroup) {
       this->blob_top_vec_);
 }
 
+TYPED_TEST(ConvolutionLayerTest, TestBatchedGemmAgainstPerImage) {
+  typedef typename TypeParam::Dtype Dtype;
+  vector<int> bottom_shape = this->blob_bottom_->shape();
+  bottom_shape[0] = 3;
+  this->blob_bottom_->Reshape(bottom_shape);
+  FillerParameter filler_param;
+  GaussianFiller<Dtype> filler(filler_param);
+  filler.Fill(this->blob_bottom_);
+  LayerParameter layer_param;
+  ConvolutionParameter* convolution_param =
+      layer_param.mutable_convolution_param();
+  convolution_param->add_kernel_size(3);
+  convolution_param->add_pad(1);
+  convolution_param->set_num_output(6);
+  convolution_param->set_group(3);
+  convolution_param->mutable_weight_filler()->set_type("gaussian");
+  convolution_param->mutable_bias_filler()->set_type("gaussian");
+  vector<bool> propagate_down(1, true);
+  // The reference: one image at a time.
+  ConvolutionLayer<Dtype> layer(layer_param);
+  layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+  Blob<Dtype> top, top_diff, bottom_diff, weight_diff, bias_diff;
+  top.CopyFrom(*this->blob_top_, false, true);
+  top_diff.ReshapeLike(*this->blob_top_);
+  filler.Fill(&top_diff);
+  caffe_copy(top_diff.count(), top_diff.cpu_data(),
+      this->blob_top_->mutable_cpu_diff());
+  layer.Backward(this->blob_top_vec_, propagate_down, this->blob_bottom_vec_);
+  bottom_diff.CopyFrom(*this->blob_bottom_, true, true);
+  weight_diff.CopyFrom(*layer.blobs()[0], true, true);
+  bias_diff.CopyFrom(*layer.blobs()[1], true, true);
+  // Batches of all three images, and of two images plus a single one.
+  const int image_bytes = sizeof(Dtype) * (3 * 3 * 3 + 6) * 6 * 4;
+  for (int batch = 2; batch <= 3; ++batch) {
+    convolution_param->set_batch_workspace_bytes(batch * image_bytes);
+    ConvolutionLayer<Dtype> batched_layer(layer_param);
+    batched_layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+    for (int i = 0; i < 2; ++i) {
+      batched_layer.blobs()[i]->CopyFrom(*layer.blobs()[i]);
+      caffe_set(batched_layer.blobs()[i]->count(), Dtype(0),
+          batched_layer.blobs()[i]->mutable_cpu_diff());
+    }
+    batched_layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+    for (int j = 0; j < top.count(); ++j) {
+      EXPECT_NEAR(top.cpu_data()[j], this->blob_top_->cpu_data()[j], 1e-4);
+    }
+    caffe_copy(top_diff.count(), top_diff.cpu_data(),
+        this->blob_top_->mutable_cpu_diff());
+    batched_layer.Backward(this->blob_top_vec_, propagate_down,
+        this->blob_bottom_vec_);
+    for (int j = 0; j < bottom_diff.count(); ++j) {
+      EXPECT_NEAR(bottom_diff.cpu_diff()[j],
+          this->blob_bottom_->cpu_diff()[j], 1e-4);
+    }
+    for (int j = 0; j < weight_diff.count(); ++j) {
+      EXPECT_NEAR(weight_diff.cpu_diff()[j],
+          batched_layer.blobs()[0]->cpu_diff()[j], 1e-4);
+    }
+    for (int j = 0; j < bias_diff.count(); ++j) {
+      EXPECT_NEAR(bias_diff.cpu_diff()[j],
+          batched_layer.blobs()[1]->cpu_diff()[j], 1e-4);
+    }
+  }
+}
+
+TYPED_TEST(ConvolutionLayerTest, TestDirectConvolution) {
+  typedef typename TypeParam::Dtype Dtype;
+  this->blob_bottom_vec_.push_back(this->blob_bottom_2_);
+  this->blob_top_vec_.push_back(this->blob_top_2_);
+  LayerParameter layer_param;
+  ConvolutionParameter* convolution_param =
+      layer_param.mutable_convolution_param();
+  convolution_param->add_kernel_size(3);
+  convolution_param->add_pad(1);
+  convolution_param->set_num_output(6);
+  convolution_param->set_group(3);
+  convolution_param->set_engine(ConvolutionParameter_Engine_DIRECT);
+  convolution_param->mutable_weight_filler()->set_type("gaussian");
+  convolution_param->mutable_bias_filler()->set_type("gaussian");
+  // Unroll a single output row at a time, and then the whole image.
+  const int kTileBytes[] = { 1, 1 << 20 };
+  for (int t = 0; t < 2; ++t) {
+    for (int stride = 1; stride <= 2; ++stride) {
+      convolution_param->set_column_tile_bytes(kTileBytes[t]);
+      convolution_param->clear_stride();
+      convolution_param->add_stride(stride);
+      DirectConvolutionLayer<Dtype> layer(layer_param);
+      layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+      layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+      for (int i = 0; i < this->blob_bottom_vec_.size(); ++i) {
+        caffe_conv(this->blob_bottom_vec_[i], convolution_param,
+            layer.blobs(), this->MakeReferenceTop(this->blob_top_vec_[i]));
+        const Dtype* top_data = this->blob_top_vec_[i]->cpu_data();
+        const Dtype* ref_top_data = this->ref_blob_top_->cpu_data();
+        for (int j = 0; j < this->blob_top_vec_[i]->count(); ++j) {
+          EXPECT_NEAR(top_data[j], ref_top_data[j], 1e-4);
+        }
+      }
+    }
+  }
+}
+
+TYPED_TEST(ConvolutionLayerTest, TestDirectGradient) {
+  typedef typename TypeParam::Dtype Dtype;
+  LayerParameter layer_param;
+  ConvolutionParameter* convolution_param =
+      layer_param.mutable_convolution_param();
+  this->blob_bottom_vec_.push_back(this->blob_bottom_2_);
+  this->blob_top_vec_.push_back(this->blob_top_2_);
+  convolution_param->add_kernel_size(3);
+  convolution_param->add_pad(1);
+  convolution_param->add_stride(2);
+  convolution_param->set_num_output(2);
+  convolution_param->set_column_tile_bytes(1);
+  convolution_param->set_engine(ConvolutionParameter_Engine_DIRECT);
+  convolution_param->mutable_weight_filler()->set_type("gaussian");
+  convolution_param->mutable_bias_filler()->set_type("gaussian");
+  DirectConvolutionLayer<Dtype> layer(layer_param);
+  GradientChecker<Dtype> checker(1e-2, 1e-3);
+  checker.CheckGradientExhaustive(&layer, this->blob_bottom_vec_,
+      this->blob_top_vec_);
+}
+
+TYPED_TEST(ConvolutionLayerTest, TestWinogradConvolution) {
+  typedef typename TypeParam::Dtype Dtype;
+  this->blob_bottom_vec_.push_back(this->blob_bottom_2_);
+  this->blob_top_vec_.push_back(this->blob_top_2_);
+  LayerParameter layer_param;
+  ConvolutionParameter* convolution_param =
+      layer_param.mutable_convolution_param();
+  convolution_param->add_kernel_size(3);
+  convolution_param->set_num_output(6);
+  convolution_param->set_group(3);
+  convolution_param->set_engine(ConvolutionParameter_Engine_WINOGRAD);
+  convolution_param->mutable_weight_filler()->set_type("gaussian");
+  convolution_param->mutable_bias_filler()->set_type("gaussian");
+  // Output tiles that fit the 6 x 4 input exactly or overhang it.
+  for (int tile = 2; tile <= 4; tile += 2) {
+    for (int pad = 0; pad <= 1; ++pad) {
+      convolution_param->set_winograd_tile(tile);
+      convolution_param->clear_pad();
+      convolution_param->add_pad(pad);
+      WinogradConvolutionLayer<Dtype> layer(layer_param);
+      layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+      layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+      for (int i = 0; i < this->blob_bottom_vec_.size(); ++i) {
+        caffe_conv(this->blob_bottom_vec_[i], convolution_param,
+            layer.blobs(), this->MakeReferenceTop(this->blob_top_vec_[i]));
+        const Dtype* top_data = this->blob_top_vec_[i]->cpu_data();
+        const Dtype* ref_top_data = this->ref_blob_top_->cpu_data();
+        for (int j = 0; j < this->blob_top_vec_[i]->count(); ++j) {
+          EXPECT_NEAR(top_data[j], ref_top_data[j], 1e-3);
+        }
+      }
+    }
+  }
+}
+
+TYPED_TEST(ConvolutionLayerTest, TestWinogradWeightsChange) {
+  typedef typename TypeParam::Dtype Dtype;
+  LayerParameter layer_param;
+  ConvolutionParameter* convolution_param =
+      layer_param.mutable_convolution_param();
+  convolution_param->add_kernel_size(3);
+  convolution_param->add_pad(1);
+  convolution_param->set_num_output(4);
+  convolution_param->set_winograd_tile(4);
+  convolution_param->set_engine(ConvolutionParameter_Engine_WINOGRAD);
+  convolution_param->mutable_weight_filler()->set_type("gaussian");
+  convolution_param->mutable_bias_filler()->set_type("gaussian");
+  WinogradConvolutionLayer<Dtype> layer(layer_param);
+  layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+  // The cached transformed filters must follow updates of the weights.
+  caffe_scal(layer.blobs()[0]->count(), Dtype(-2),
+      layer.blobs()[0]->mutable_cpu_data());
+  layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+  caffe_conv(this->blob_bottom_, convolution_param, layer.blobs(),
+      this->MakeReferenceTop(this->blob_top_));
+  const Dtype* top_data = this->blob_top_->cpu_data();
+  const Dtype* ref_top_data = this->ref_blob_top_->cpu_data();
+  for (int i = 0; i < this->blob_top_->count(); ++i) {
+    EXPECT_NEAR(top_data[i], ref_top_data[i], 1e-3);
+  }
+}
+
+TYPED_TEST(ConvolutionLayerTest, TestWinogradGradient) {
+  typedef typename TypeParam::Dtype Dtype;
+  LayerParameter layer_param;
+  ConvolutionParameter* convolution_param =
+      layer_param.mutable_convolution_param();
+  this->blob_bottom_vec_.push_back(this->blob_bottom_2_);
+  this->blob_top_vec_.push_back(this->blob_top_2_);
+  convolution_param->add_kernel_size(3);
+  convolution_param->add_pad(1);
+  convolution_param->set_num_output(2);
+  convolution_param->set_engine(ConvolutionParameter_Engine_WINOGRAD);
+  convolution_param->mutable_weight_filler()->set_type("gaussian");
+  convolution_param->mutable_bias_filler()->set_type("gaussian");
+  WinogradConvolutionLayer<Dtype> layer(layer_param);
+  GradientChecker<Dtype> checker(1e-2, 1e-3);
+  checker.CheckGradientExhaustive(&layer, this->blob_bottom_vec_,
+      this->blob_top_vec_);
+}
+
 #ifdef USE_CUDNN
 
 template <typename Dtype>
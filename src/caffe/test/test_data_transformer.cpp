@@ -353,5 +353,61 @@ TYPED_TEST(DataTransformTest, TestMeanFile) {
   }
 }
 
+// Rows long enough to be transformed in blocks, plus a remainder.
+TYPED_TEST(DataTransformTest, TestCropMirrorMeanFileWide) {
+  TransformationParameter transform_param;
+  const bool unique_pixels = true;  // pixels are consecutive ints [0,size]
+  const int label = 0;
+  const int channels = 2;
+  const int size = 38;
+  const int crop_size = 36;
+  const TypeParam scale = 0.5;
+
+  string mean_file;
+  MakeTempFilename(&mean_file);
+  BlobProto blob_mean;
+  blob_mean.set_num(1);
+  blob_mean.set_channels(channels);
+  blob_mean.set_height(size);
+  blob_mean.set_width(size);
+  for (int j = 0; j < channels * size * size; ++j) {
+    blob_mean.add_data(j % 7);
+  }
+  WriteProtoToBinaryFile(blob_mean, mean_file);
+  transform_param.set_mean_file(mean_file);
+  transform_param.set_scale(scale);
+  transform_param.set_crop_size(crop_size);
+  transform_param.set_mirror(true);
+  Datum datum;
+  FillDatum(label, channels, size, size, unique_pixels, &datum);
+  Blob<TypeParam> blob(1, channels, crop_size, crop_size);
+  Caffe::set_random_seed(this->seed_);
+  DataTransformer<TypeParam> transformer(transform_param, TEST);
+  transformer.InitRand();
+  int num_mirrored = 0;
+  for (int iter = 0; iter < this->num_iter_; ++iter) {
+    transformer.Transform(datum, &blob);
+    bool mirrored = true, unmirrored = true;
+    for (int c = 0; c < channels; ++c) {
+      for (int h = 0; h < crop_size; ++h) {
+        const TypeParam* row =
+            blob.cpu_data() + (c * crop_size + h) * crop_size;
+        for (int w = 0; w < crop_size; ++w) {
+          // At TEST time the crop is centered, one pixel in.
+          const int index = (c * size + h + 1) * size + w + 1;
+          const TypeParam expected =
+              (static_cast<uint8_t>(index) - index % 7) * scale;
+          unmirrored &= row[w] == expected;
+          mirrored &= row[crop_size - 1 - w] == expected;
+        }
+      }
+    }
+    EXPECT_TRUE(mirrored || unmirrored);
+    num_mirrored += mirrored;
+  }
+  EXPECT_GT(num_mirrored, 0);
+  EXPECT_LT(num_mirrored, this->num_iter_);
+}
+
 }  // namespace caffe
 #endif  // USE_OPENCV
@@ -93,6 +93,22 @@ TYPED_TEST(DBTest, TestSeekToFirst) {
   EXPECT_EQ(datum.width(), 480);
 }
 
+TYPED_TEST(DBTest, TestSeek) {
+  scoped_ptr<db::DB> db(db::GetDB(TypeParam::backend));
+  db->Open(this->source_, db::READ);
+  scoped_ptr<db::Cursor> cursor(db->NewCursor());
+  cursor->Seek("fish-bike.jpg");
+  EXPECT_TRUE(cursor->valid());
+  EXPECT_EQ(cursor->key(), "fish-bike.jpg");
+  cursor->Seek("d");
+  EXPECT_TRUE(cursor->valid());
+  EXPECT_EQ(cursor->key(), "fish-bike.jpg");
+  cursor->Seek("cat.jpg");
+  EXPECT_EQ(cursor->key(), "cat.jpg");
+  cursor->Seek("z");
+  EXPECT_FALSE(cursor->valid());
+}
+
 TYPED_TEST(DBTest, TestKeyValue) {
   scoped_ptr<db::DB> db(db::GetDB(TypeParam::backend));
   db->Open(this->source_, db::READ);
@@ -117,6 +133,21 @@ TYPED_TEST(DBTest, TestKeyValue) {
   EXPECT_FALSE(cursor->valid());
 }
 
+TYPED_TEST(DBTest, TestValueData) {
+  scoped_ptr<db::DB> db(db::GetDB(TypeParam::backend));
+  db->Open(this->source_, db::READ);
+  scoped_ptr<db::Cursor> cursor(db->NewCursor());
+  for (; cursor->valid(); cursor->Next()) {
+    const string value = cursor->value();
+    ASSERT_EQ(cursor->value_size(), value.size());
+    EXPECT_EQ(string(cursor->value_data(), cursor->value_size()), value);
+    Datum datum;
+    EXPECT_TRUE(datum.ParseFromArray(cursor->value_data(),
+        cursor->value_size()));
+    EXPECT_EQ(datum.channels(), 3);
+  }
+}
+
 TYPED_TEST(DBTest, TestWrite) {
   scoped_ptr<db::DB> db(db::GetDB(TypeParam::backend));
   db->Open(this->source_, db::WRITE);
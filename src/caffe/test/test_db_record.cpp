@@ -0,0 +1,125 @@
+#include <string>
+
+#include "boost/scoped_ptr.hpp"
+#include "gtest/gtest.h"
+
+#include "caffe/common.hpp"
+#include "caffe/proto/caffe.pb.h"
+#include "caffe/util/db_record.hpp"
+#include "caffe/util/io.hpp"
+
+#include "caffe/test/test_caffe_main.hpp"
+
+namespace caffe {
+
+using boost::scoped_ptr;
+
+class RecordDBTest : public ::testing::Test {
+ protected:
+  RecordDBTest() {
+    MakeTempFilename(&source_);
+    scoped_ptr<db::DB> db(db::GetDB("record"));
+    db->Open(source_, db::NEW);
+    scoped_ptr<db::Transaction> txn(db->NewTransaction());
+    // Written out of order; the raw one, then an encoded and a float one.
+    Datum datum;
+    datum.set_channels(2);
+    datum.set_height(1);
+    datum.set_width(3);
+    datum.set_label(1);
+    datum.set_data("\x01\x02\x03\x04\x05\x06", 6);
+    txn->Put("b", Serialize(datum));
+    datum.set_label(0);
+    datum.set_data("image");
+    datum.set_encoded(true);
+    txn->Put("a", Serialize(datum));
+    txn->Commit();
+    datum.Clear();
+    datum.set_channels(1);
+    datum.set_height(1);
+    datum.set_width(2);
+    datum.set_label(2);
+    datum.add_float_data(0.5);
+    datum.add_float_data(-3);
+    txn->Put("ccc", Serialize(datum));
+    txn->Commit();
+  }
+
+  static string Serialize(const Datum& datum) {
+    string value;
+    CHECK(datum.SerializeToString(&value));
+    return value;
+  }
+
+  string source_;
+};
+
+TEST_F(RecordDBTest, TestRead) {
+  scoped_ptr<db::DB> db(db::GetDB(DataParameter_DB_RECORD));
+  db->Open(source_, db::READ);
+  scoped_ptr<db::Cursor> cursor(db->NewCursor());
+  Datum datum;
+  ASSERT_TRUE(cursor->valid());
+  EXPECT_EQ(cursor->key(), "a");
+  cursor->ParseDatum(&datum);
+  EXPECT_EQ(datum.label(), 0);
+  EXPECT_TRUE(datum.encoded());
+  EXPECT_EQ(datum.data(), "image");
+  cursor->Next();
+  ASSERT_TRUE(cursor->valid());
+  EXPECT_EQ(cursor->key(), "b");
+  cursor->ParseDatum(&datum);
+  EXPECT_EQ(datum.channels(), 2);
+  EXPECT_EQ(datum.height(), 1);
+  EXPECT_EQ(datum.width(), 3);
+  EXPECT_EQ(datum.label(), 1);
+  EXPECT_FALSE(datum.encoded());
+  EXPECT_EQ(datum.data(), string("\x01\x02\x03\x04\x05\x06", 6));
+  EXPECT_EQ(datum.float_data_size(), 0);
+  cursor->Next();
+  ASSERT_TRUE(cursor->valid());
+  EXPECT_EQ(cursor->key(), "ccc");
+  cursor->ParseDatum(&datum);
+  EXPECT_EQ(datum.label(), 2);
+  EXPECT_FALSE(datum.has_data());
+  ASSERT_EQ(datum.float_data_size(), 2);
+  EXPECT_EQ(datum.float_data(0), 0.5);
+  EXPECT_EQ(datum.float_data(1), -3);
+  cursor->Next();
+  EXPECT_FALSE(cursor->valid());
+}
+
+TEST_F(RecordDBTest, TestValue) {
+  scoped_ptr<db::DB> db(db::GetDB("record"));
+  db->Open(source_, db::READ);
+  scoped_ptr<db::Cursor> cursor(db->NewCursor());
+  for (; cursor->valid(); cursor->Next()) {
+    Datum parsed, datum;
+    cursor->ParseDatum(&parsed);
+    EXPECT_TRUE(datum.ParseFromString(cursor->value()));
+    EXPECT_EQ(Serialize(datum), Serialize(parsed));
+    EXPECT_EQ(string(cursor->value_data(), cursor->value_size()),
+        cursor->value());
+  }
+}
+
+TEST_F(RecordDBTest, TestSeek) {
+  scoped_ptr<db::DB> db(db::GetDB("record"));
+  db->Open(source_, db::READ);
+  scoped_ptr<db::Cursor> cursor(db->NewCursor());
+  cursor->Seek("b");
+  ASSERT_TRUE(cursor->valid());
+  EXPECT_EQ(cursor->key(), "b");
+  cursor->Seek("cc");
+  ASSERT_TRUE(cursor->valid());
+  EXPECT_EQ(cursor->key(), "ccc");
+  cursor->Seek("");
+  ASSERT_TRUE(cursor->valid());
+  EXPECT_EQ(cursor->key(), "a");
+  cursor->Seek("d");
+  EXPECT_FALSE(cursor->valid());
+  cursor->SeekToFirst();
+  EXPECT_EQ(cursor->key(), "a");
+}
+
+}  // namespace caffe
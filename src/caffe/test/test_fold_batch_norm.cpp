@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "google/protobuf/text_format.h"
+
+#include "gtest/gtest.h"
+
+#include "caffe/common.hpp"
+#include "caffe/filler.hpp"
+#include "caffe/net.hpp"
+#include "caffe/util/fold_batch_norm.hpp"
+
+#include "caffe/test/test_caffe_main.hpp"
+
+namespace caffe {
+
+template <typename TypeParam>
+class FoldBatchNormTest : public MultiDeviceTest<TypeParam> {
+  typedef typename TypeParam::Dtype Dtype;
+
+ protected:
+  FoldBatchNormTest() {
+    // conv1 without bias, in-place BatchNorm and ReLU; conv2 with bias and
+    // a BatchNorm and ReLU that are not in-place; ip with a BatchNorm.
+    const string& proto =
+        "input: 'data' "
+        "input_shape { dim: 2 dim: 3 dim: 6 dim: 5 } "
+        "layer { "
+        "  name: 'conv1' type: 'Convolution' bottom: 'data' top: 'conv1' "
+        "  convolution_param { num_output: 4 kernel_size: 3 pad: 1 "
+        "    bias_term: false weight_filler { type: 'gaussian' std: 0.3 } } "
+        "} "
+        "layer { name: 'bn1' type: 'BatchNorm' bottom: 'conv1' top: 'conv1' } "
+        "layer { name: 'relu1' type: 'ReLU' bottom: 'conv1' top: 'conv1' } "
+        "layer { "
+        "  name: 'conv2' type: 'Convolution' bottom: 'conv1' top: 'conv2' "
+        "  convolution_param { num_output: 5 kernel_size: 3 "
+        "    weight_filler { type: 'gaussian' std: 0.3 } "
+        "    bias_filler { type: 'gaussian' std: 0.3 } } "
+        "} "
+        "layer { name: 'bn2' type: 'BatchNorm' bottom: 'conv2' top: 'bn2' } "
+        "layer { name: 'relu2' type: 'ReLU' bottom: 'bn2' top: 'relu2' } "
+        "layer { "
+        "  name: 'ip' type: 'InnerProduct' bottom: 'relu2' top: 'ip' "
+        "  inner_product_param { num_output: 3 "
+        "    weight_filler { type: 'gaussian' std: 0.3 } } "
+        "} "
+        "layer { name: 'bn3' type: 'BatchNorm' bottom: 'ip' top: 'ip' } ";
+    CHECK(google::protobuf::TextFormat::ParseFromString(proto, &param_));
+  }
+
+  // Random BatchNorm statistics, attached with the other blobs to param_.
+  void FillAndAttachBlobs(const Net<Dtype>& net) {
+    FillerParameter filler_param;
+    GaussianFiller<Dtype> gaussian(filler_param);
+    filler_param.set_min(0.5);
+    filler_param.set_max(2);
+    UniformFiller<Dtype> uniform(filler_param);
+    for (int i = 0; i < param_.layer_size(); ++i) {
+      LayerParameter* layer_param = param_.mutable_layer(i);
+      const vector<shared_ptr<Blob<Dtype> > >& blobs =
+          net.layer_by_name(layer_param->name())->blobs();
+      if (layer_param->type() == "BatchNorm") {
+        gaussian.Fill(blobs[0].get());
+        uniform.Fill(blobs[1].get());
+        // Stored statistics are sums scaled by this factor.
+        blobs[2]->mutable_cpu_data()[0] = 2;
+      }
+      for (int j = 0; j < blobs.size(); ++j) {
+        blobs[j]->ToProto(layer_param->add_blobs());
+      }
+    }
+  }
+
+  NetParameter param_;
+};
+
+TYPED_TEST_CASE(FoldBatchNormTest, TestDtypesAndDevices);
+
+TYPED_TEST(FoldBatchNormTest, TestFoldedNet) {
+  typedef typename TypeParam::Dtype Dtype;
+  NetParameter folded;
+  {
+    Net<Dtype> net(this->param_);
+    this->FillAndAttachBlobs(net);
+  }
+  FoldBatchNorm(this->param_, &folded);
+  ASSERT_EQ(folded.layer_size(), 3);
+  const LayerParameter& conv1 = folded.layer(0);
+  EXPECT_EQ(conv1.top(0), "conv1");
+  EXPECT_TRUE(conv1.convolution_param().bias_term());
+  EXPECT_TRUE(conv1.convolution_param().fused_relu());
+  EXPECT_EQ(conv1.blobs_size(), 2);
+  // The folded blobs keep the precision of the net they came from.
+  const bool is_double = sizeof(Dtype) == sizeof(double);
+  EXPECT_EQ(conv1.blobs(1).double_data_size() > 0, is_double);
+  EXPECT_EQ(conv1.blobs(1).data_size() > 0, !is_double);
+  const LayerParameter& conv2 = folded.layer(1);
+  EXPECT_EQ(conv2.top(0), "relu2");
+  EXPECT_TRUE(conv2.convolution_param().fused_relu());
+  EXPECT_EQ(folded.layer(2).name(), "ip");
+  EXPECT_EQ(folded.layer(2).bottom(0), "relu2");
+}
+
+TYPED_TEST(FoldBatchNormTest, TestFoldedNetEquivalence) {
+  typedef typename TypeParam::Dtype Dtype;
+  Net<Dtype> net(this->param_);
+  this->FillAndAttachBlobs(net);
+  NetParameter folded;
+  FoldBatchNorm(this->param_, &folded);
+  Net<Dtype> folded_net(folded);
+  FillerParameter filler_param;
+  GaussianFiller<Dtype> filler(filler_param);
+  filler.Fill(net.input_blobs()[0]);
+  folded_net.input_blobs()[0]->CopyFrom(*net.input_blobs()[0]);
+  net.ForwardPrefilled();
+  folded_net.ForwardPrefilled();
+  // Double nets are folded without a round trip through float.
+  const Dtype tolerance = sizeof(Dtype) == sizeof(double) ? 1e-9 : 1e-4;
+  const char* blob_names[] = { "conv1", "relu2", "ip" };
+  for (int i = 0; i < 3; ++i) {
+    const Blob<Dtype>* blob = net.blob_by_name(blob_names[i]).get();
+    const Blob<Dtype>* folded_blob =
+        folded_net.blob_by_name(blob_names[i]).get();
+    ASSERT_EQ(blob->count(), folded_blob->count());
+    for (int j = 0; j < blob->count(); ++j) {
+      const Dtype expected = blob->cpu_data()[j];
+      EXPECT_NEAR(folded_blob->cpu_data()[j], expected,
+          tolerance * std::max(Dtype(1), std::abs(expected)))
+          << blob_names[i];
+    }
+  }
+}
+
+}  // namespace caffe
@@ -26,7 +26,7 @@ class GradientBasedSolverTest : public MultiDeviceTest<TypeParam> {
  protected:
   GradientBasedSolverTest() :
       seed_(1701), num_(4), channels_(3), height_(10), width_(10),
-      share_(false) {
+      share_(false), snapshot_async_(false), workers_(1) {
         input_file_ = new string(
         CMAKE_SOURCE_DIR "caffe/test/test_data/solver_data_list.txt" CMAKE_EXT);
       }
@@ -42,6 +42,8 @@ class GradientBasedSolverTest : public MultiDeviceTest<TypeParam> {
   // TODO this is brittle and the hdf5 file should be checked instead.
   int num_, channels_, height_, width_;
   bool share_;
+  bool snapshot_async_;
+  int workers_;  // CPU data parallel solvers, run through CPUSync
   Dtype delta_;  // Stability constant for RMSProp, AdaGrad, AdaDelta and Adam
 
   // Test data: check out generate_sample_data.py in the same directory.
@@ -181,7 +183,11 @@ class GradientBasedSolverTest : public MultiDeviceTest<TypeParam> {
     if (snapshot) {
       proto << "snapshot: " << num_iters << " ";
     }
+    if (snapshot_async_) {
+      proto << "snapshot_async: true ";
+    }
     Caffe::set_random_seed(this->seed_);
+    Caffe::set_solver_count(workers_);
     this->InitSolverFromProtoString(proto.str());
     if (from_snapshot != NULL) {
       this->solver_->Restore(from_snapshot);
@@ -190,7 +196,12 @@ class GradientBasedSolverTest : public MultiDeviceTest<TypeParam> {
         this->solver_->net()->Forward(empty_bottom_vec);
       }
     }
-    if (devices == 1) {
+    if (workers_ > 1) {
+      LOG(INFO) << "Multi-CPU test on " << workers_ << " workers";
+      CPUSync<Dtype> sync(this->solver_);
+      sync.run(workers_);
+      Caffe::set_solver_count(1);
+    } else if (devices == 1) {
       this->solver_->Solve();
     } else {
       LOG(INFO) << "Multi-GPU test on " << devices << " devices";
@@ -464,15 +475,20 @@ class GradientBasedSolverTest : public MultiDeviceTest<TypeParam> {
       CUDA_CHECK(cudaGetDeviceCount(&available_devices));
     }
 #endif
+    const int workers = workers_;
     for (int devices = 1; devices <= available_devices; ++devices) {
       // Configure batch size for single / multi device equivalence.
       // Constant data is needed for multi device as for accumulation.
-      num_ = kNum * devices;
+      // CPU workers share the data layer, so together they take workers
+      // consecutive batches each iteration.
+      num_ = kNum * devices * workers;
 
       // Initialize the solver and run K (= iter_to_check) solver iterations
       // (on single device).
+      workers_ = 1;
       RunLeastSquaresSolver(learning_rate, weight_decay, momentum,
                             iter_to_check, kIterSize, 1);
+      workers_ = workers;
 
       // Compute the (K+1)th update using the analytic least squares gradient.
       vector<shared_ptr<Blob<Dtype> > > updated_params;
@@ -638,6 +654,77 @@ TYPED_TEST(SGDSolverTest, TestLeastSquaresUpdateWithEverything) {
   }
 }
 
+TYPED_TEST(SGDSolverTest, TestLeastSquaresUpdateWithEverythingWorkers) {
+  typedef typename TypeParam::Dtype Dtype;
+  if (Caffe::mode() != Caffe::CPU) {
+    return;
+  }
+  const Dtype kLearningRate = 0.01;
+  const Dtype kWeightDecay = 0.5;
+  const Dtype kMomentum = 0.5;
+  const int kNumIters = 4;
+  this->workers_ = 2;
+  for (int i = 0; i <= kNumIters; ++i) {
+    this->TestLeastSquaresUpdate(kLearningRate, kWeightDecay, kMomentum, i);
+  }
+}
+
+TYPED_TEST(SGDSolverTest, TestWorkersFollowWinogradUpdates) {
+  typedef typename TypeParam::Dtype Dtype;
+  if (Caffe::mode() != Caffe::CPU) {
+    return;
+  }
+  // Winograd convolution caches its transformed filters by version. The
+  // workers read the root's params, so they have to see every update as
+  // a new version and train exactly like the plain engine.
+  const char* engines[] = { "CAFFE", "WINOGRAD" };
+  vector<vector<Dtype> > trained(2);
+  for (int e = 0; e < 2; ++e) {
+    ostringstream proto;
+    proto <<
+       "max_iter: 4 base_lr: 0.1 lr_policy: 'fixed' random_seed: 1701 "
+       "snapshot_after_train: false "
+       "net_param { "
+       "  name: 'TestNetwork' "
+       "  layer { "
+       "    name: 'data' type: 'HDF5Data' top: 'data' top: 'targets' "
+       "    hdf5_data_param { "
+       "      source: '" << *(this->input_file_) << "' batch_size: 2 "
+       "    } "
+       "  } "
+       "  layer { "
+       "    name: 'conv' type: 'Convolution' bottom: 'data' top: 'conv' "
+       "    convolution_param { num_output: 2 kernel_size: 3 "
+       "      bias_term: false engine: " << engines[e] << " "
+       "      weight_filler { type: 'gaussian' std: 0.1 } } "
+       "  } "
+       "  layer { "
+       "    name: 'innerprod' type: 'InnerProduct' bottom: 'conv' "
+       "    top: 'innerprod' "
+       "    inner_product_param { num_output: 1 "
+       "      weight_filler { type: 'gaussian' std: 0.1 } } "
+       "  } "
+       "  layer { "
+       "    name: 'loss' type: 'EuclideanLoss' bottom: 'innerprod' "
+       "    bottom: 'targets' "
+       "  } "
+       "} ";
+    Caffe::set_random_seed(this->seed_);
+    Caffe::set_solver_count(2);
+    this->InitSolverFromProtoString(proto.str());
+    CPUSync<Dtype> sync(this->solver_);
+    sync.run(2);
+    Caffe::set_solver_count(1);
+    const Blob<Dtype>& params = *this->solver_->net()->flat_params();
+    trained[e].assign(params.cpu_data(), params.cpu_data() + params.count());
+  }
+  ASSERT_EQ(trained[0].size(), trained[1].size());
+  for (int i = 0; i < trained[0].size(); ++i) {
+    EXPECT_NEAR(trained[0][i], trained[1][i],
+        1e-4 * std::max(Dtype(1), std::fabs(trained[0][i])));
+  }
+}
+
 TYPED_TEST(SGDSolverTest, TestLeastSquaresUpdateWithEverythingShare) {
   typedef typename TypeParam::Dtype Dtype;
   const Dtype kLearningRate = 0.01;
@@ -696,6 +783,18 @@ TYPED_TEST(SGDSolverTest, TestSnapshotShare) {
   }
 }
 
+TYPED_TEST(SGDSolverTest, TestSnapshotAsync) {
+  typedef typename TypeParam::Dtype Dtype;
+  const Dtype kLearningRate = 0.01;
+  const Dtype kWeightDecay = 0.5;
+  const Dtype kMomentum = 0.9;
+  const int kNumIters = 4;
+  this->snapshot_async_ = true;
+  for (int i = 1; i <= kNumIters; ++i) {
+    this->TestSnapshot(kLearningRate, kWeightDecay, kMomentum, i);
+  }
+}
+
 
 template <typename TypeParam>
 class AdaGradSolverTest : public GradientBasedSolverTest<TypeParam> {
@@ -1103,6 +1202,22 @@ TYPED_TEST(AdamSolverTest, TestAdamLeastSquaresUpdateWithEverything) {
   }
 }
 
+TYPED_TEST(AdamSolverTest, TestAdamLeastSquaresUpdateWithEverythingWorkers) {
+  typedef typename TypeParam::Dtype Dtype;
+  if (Caffe::mode() != Caffe::CPU) {
+    return;
+  }
+  const Dtype kLearningRate = 0.01;
+  const Dtype kWeightDecay = 0.5;
+  const Dtype kMomentum = 0.9;
+  const int kNumIters = 4;
+  this->workers_ = 2;
+  this->share_ = true;
+  for (int i = 0; i <= kNumIters; ++i) {
+    this->TestLeastSquaresUpdate(kLearningRate, kWeightDecay, kMomentum, i);
+  }
+}
+
 TYPED_TEST(AdamSolverTest, TestAdamLeastSquaresUpdateWithEverythingShare) {
   typedef typename TypeParam::Dtype Dtype;
   const Dtype kLearningRate = 0.01;
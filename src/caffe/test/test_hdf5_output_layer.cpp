@@ -9,6 +9,7 @@
 #include "caffe/proto/caffe.pb.h"
 #include "caffe/util/hdf5.hpp"
 #include "caffe/util/io.hpp"
+#include "caffe/util/math_functions.hpp"
 
 #include "caffe/test/test_caffe_main.hpp"
 
@@ -94,6 +95,8 @@ TYPED_TEST(HDF5OutputLayerTest, TestForward) {
   {
     HDF5OutputLayer<Dtype> layer(param);
     layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+    // A second SetUp leaves the open file and its writer alone.
+    layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
     EXPECT_EQ(layer.file_name(), this->output_file_name_);
     layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
   }
@@ -103,6 +106,13 @@ TYPED_TEST(HDF5OutputLayerTest, TestForward) {
     file_id, 0)<< "Failed to open HDF5 file" <<
           this->input_file_name_;
 
+  // Both datasets are written 4-D, whatever the rank of the bottoms.
+  int ndims;
+  H5LTget_dataset_ndims(file_id, HDF5_DATA_DATASET_NAME, &ndims);
+  EXPECT_EQ(ndims, 4);
+  H5LTget_dataset_ndims(file_id, HDF5_DATA_LABEL_NAME, &ndims);
+  EXPECT_EQ(ndims, 4);
+
   Blob<Dtype>* blob_data = new Blob<Dtype>();
   hdf5_load_nd_dataset(file_id, HDF5_DATA_DATASET_NAME, 0, 4,
                        blob_data);
@@ -118,4 +128,65 @@ TYPED_TEST(HDF5OutputLayerTest, TestForward) {
       this->output_file_name_;
 }
 
+TYPED_TEST(HDF5OutputLayerTest, TestForwardAppends) {
+  typedef typename TypeParam::Dtype Dtype;
+  hid_t file_id = H5Fopen(this->input_file_name_.c_str(), H5F_ACC_RDONLY,
+                          H5P_DEFAULT);
+  ASSERT_GE(file_id, 0)<< "Failed to open HDF5 file" <<
+      this->input_file_name_;
+  hdf5_load_nd_dataset(file_id, HDF5_DATA_DATASET_NAME, 0, 4,
+                       this->blob_data_);
+  hdf5_load_nd_dataset(file_id, HDF5_DATA_LABEL_NAME, 0, 4,
+                       this->blob_label_);
+  H5Fclose(file_id);
+  this->blob_bottom_vec_.push_back(this->blob_data_);
+  this->blob_bottom_vec_.push_back(this->blob_label_);
+  Blob<Dtype> expected_data, expected_label;
+  expected_data.CopyFrom(*this->blob_data_, false, true);
+  expected_label.CopyFrom(*this->blob_label_, false, true);
+
+  // A queue of one batch, chunks that don't match the batches, compression.
+  LayerParameter param;
+  HDF5OutputParameter* hdf5_output_param = param.mutable_hdf5_output_param();
+  hdf5_output_param->set_file_name(this->output_file_name_);
+  hdf5_output_param->set_chunk_rows(2);
+  hdf5_output_param->set_compression_level(6);
+  hdf5_output_param->set_queue_size(1);
+  const int num_batches = 3;
+  {
+    HDF5OutputLayer<Dtype> layer(param);
+    layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+    for (int i = 0; i < num_batches; ++i) {
+      layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+      // Forward copies the bottoms, so they can change right away.
+      caffe_add_scalar(this->blob_data_->count(), Dtype(1),
+                       this->blob_data_->mutable_cpu_data());
+      caffe_add_scalar(this->blob_label_->count(), Dtype(1),
+                       this->blob_label_->mutable_cpu_data());
+    }
+  }
+  file_id = H5Fopen(this->output_file_name_.c_str(), H5F_ACC_RDONLY,
+                    H5P_DEFAULT);
+  ASSERT_GE(file_id, 0) << "Failed to open HDF5 file" <<
+      this->output_file_name_;
+  EXPECT_EQ(hdf5_get_num_rows(file_id, HDF5_DATA_DATASET_NAME),
+            hsize_t(num_batches * this->blob_data_->num()));
+  EXPECT_EQ(hdf5_get_num_rows(file_id, HDF5_DATA_LABEL_NAME),
+            hsize_t(num_batches * this->blob_label_->num()));
+  Blob<Dtype> blob_data, blob_label;
+  for (int i = 0; i < num_batches; ++i) {
+    hdf5_load_nd_dataset_rows(file_id, HDF5_DATA_DATASET_NAME,
+        i * expected_data.num(), expected_data.num(), 0, 4, &blob_data);
+    this->CheckBlobEqual(expected_data, blob_data);
+    hdf5_load_nd_dataset_rows(file_id, HDF5_DATA_LABEL_NAME,
+        i * expected_label.num(), expected_label.num(), 0, 4, &blob_label);
+    this->CheckBlobEqual(expected_label, blob_label);
+    caffe_add_scalar(expected_data.count(), Dtype(1),
+                     expected_data.mutable_cpu_data());
+    caffe_add_scalar(expected_label.count(), Dtype(1),
+                     expected_label.mutable_cpu_data());
+  }
+  H5Fclose(file_id);
+}
+
 }  // namespace caffe
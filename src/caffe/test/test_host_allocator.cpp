@@ -0,0 +1,81 @@
+#include <stdint.h>
+
+#include "gtest/gtest.h"
+
+#include "caffe/common.hpp"
+#include "caffe/syncedmem.hpp"
+#include "caffe/util/host_allocator.hpp"
+#include "caffe/util/math_functions.hpp"
+
+#include "caffe/test/test_caffe_main.hpp"
+
+namespace caffe {
+
+class HostAllocatorTest : public ::testing::Test {};
+
+TEST_F(HostAllocatorTest, TestSizeClass) {
+  EXPECT_EQ(HostAllocator::SizeClass(0), 64);
+  EXPECT_EQ(HostAllocator::SizeClass(1), 64);
+  EXPECT_EQ(HostAllocator::SizeClass(64), 64);
+  EXPECT_EQ(HostAllocator::SizeClass(65), 128);
+  EXPECT_EQ(HostAllocator::SizeClass(1000), 1024);
+  EXPECT_EQ(HostAllocator::SizeClass(1025), 1280);
+  EXPECT_EQ(HostAllocator::SizeClass(1 << 20), 1 << 20);
+  EXPECT_EQ(HostAllocator::SizeClass((1 << 20) + 1), (1 << 20) + (1 << 18));
+  for (size_t size = 1; size < (1 << 16); size += 77) {
+    const size_t bytes = HostAllocator::SizeClass(size);
+    EXPECT_GE(bytes, size);
+    EXPECT_EQ(bytes % HostAllocator::kAlignment, 0);
+    if (size > HostAllocator::kAlignment) {
+      EXPECT_LE(bytes, size + size / 4 + HostAllocator::kAlignment);
+    }
+  }
+}
+
+TEST_F(HostAllocatorTest, TestReuse) {
+  HostAllocator::ReleaseCached();
+  const HostAllocator::Stats before = HostAllocator::stats();
+  EXPECT_EQ(before.bytes_cached, 0);
+  void* ptr = HostAllocator::Allocate(1000);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % HostAllocator::kAlignment, 0);
+  HostAllocator::Stats stats = HostAllocator::stats();
+  EXPECT_EQ(stats.bytes_in_use, before.bytes_in_use + 1024);
+  EXPECT_EQ(stats.misses, before.misses + 1);
+  HostAllocator::Free(ptr, 1000);
+  stats = HostAllocator::stats();
+  EXPECT_EQ(stats.bytes_in_use, before.bytes_in_use);
+  EXPECT_EQ(stats.bytes_cached, 1024);
+  // Another request of the same size class gets the cached block back.
+  EXPECT_EQ(HostAllocator::Allocate(1010), ptr);
+  stats = HostAllocator::stats();
+  EXPECT_EQ(stats.hits, before.hits + 1);
+  EXPECT_EQ(stats.bytes_cached, 0);
+  HostAllocator::Free(ptr, 1010);
+  HostAllocator::ReleaseCached();
+  EXPECT_EQ(HostAllocator::stats().bytes_cached, 0);
+}
+
+TEST_F(HostAllocatorTest, TestSyncedMemory) {
+  Caffe::set_mode(Caffe::CPU);
+  HostAllocator::ReleaseCached();
+  const HostAllocator::Stats before = HostAllocator::stats();
+  void* data;
+  {
+    SyncedMemory mem(3000);
+    data = mem.mutable_cpu_data();
+    EXPECT_EQ(HostAllocator::stats().bytes_in_use,
+        before.bytes_in_use + HostAllocator::SizeClass(3000));
+    caffe_memset(3000, 1, data);
+  }
+  EXPECT_EQ(HostAllocator::stats().bytes_in_use, before.bytes_in_use);
+  // Reused memory is handed out zeroed all the same.
+  SyncedMemory mem(3000);
+  const char* reused = static_cast<const char*>(mem.cpu_data());
+  EXPECT_EQ(reused, data);
+  for (int i = 0; i < 3000; ++i) {
+    EXPECT_EQ(reused[i], 0);
+  }
+  EXPECT_EQ(HostAllocator::stats().hits, before.hits + 1);
+}
+
+}  // namespace caffe
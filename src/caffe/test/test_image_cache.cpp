@@ -0,0 +1,76 @@
+#ifdef USE_OPENCV
+#include <opencv2/core/core.hpp>
+
+#include "gtest/gtest.h"
+
+#include "caffe/common.hpp"
+#include "caffe/util/image_cache.hpp"
+
+#include "caffe/test/test_caffe_main.hpp"
+
+namespace caffe {
+
+class ImageCacheTest : public ::testing::Test {
+ protected:
+  // A 10x10 3 channel image, 300 bytes, filled with value.
+  static cv::Mat Image(int value) {
+    return cv::Mat(10, 10, CV_8UC3, cv::Scalar(value, value, value));
+  }
+};
+
+TEST_F(ImageCacheTest, TestLookup) {
+  ImageCache cache(1000);
+  cv::Mat image;
+  EXPECT_FALSE(cache.Lookup("a", &image));
+  cache.Insert("a", Image(1));
+  cache.Insert("b", Image(2));
+  EXPECT_EQ(cache.size(), 600);
+  ASSERT_TRUE(cache.Lookup("a", &image));
+  EXPECT_EQ(image.at<cv::Vec3b>(9, 9)[2], 1);
+  ASSERT_TRUE(cache.Lookup("b", &image));
+  EXPECT_EQ(image.at<cv::Vec3b>(0, 0)[0], 2);
+  EXPECT_EQ(cache.hits(), 2);
+  EXPECT_EQ(cache.misses(), 1);
+  cache.Clear();
+  EXPECT_EQ(cache.size(), 0);
+  EXPECT_FALSE(cache.Lookup("a", &image));
+}
+
+TEST_F(ImageCacheTest, TestEvictLeastRecentlyUsed) {
+  ImageCache cache(1000);
+  cv::Mat image;
+  cache.Insert("a", Image(1));
+  cache.Insert("b", Image(2));
+  cache.Insert("c", Image(3));
+  // Using a makes b the least recently used image.
+  EXPECT_TRUE(cache.Lookup("a", &image));
+  cache.Insert("d", Image(4));
+  EXPECT_EQ(cache.size(), 900);
+  EXPECT_FALSE(cache.Lookup("b", &image));
+  EXPECT_TRUE(cache.Lookup("a", &image));
+  EXPECT_TRUE(cache.Lookup("c", &image));
+  EXPECT_TRUE(cache.Lookup("d", &image));
+  // Evicted images stay valid for whoever still holds them.
+  cv::Mat held;
+  ASSERT_TRUE(cache.Lookup("a", &held));
+  cache.Clear();
+  EXPECT_EQ(held.at<cv::Vec3b>(5, 5)[1], 1);
+}
+
+TEST_F(ImageCacheTest, TestBudget) {
+  ImageCache cache(200);
+  cv::Mat image;
+  // Larger than the whole budget.
+  cache.Insert("a", Image(1));
+  EXPECT_EQ(cache.size(), 0);
+  EXPECT_FALSE(cache.Lookup("a", &image));
+  cache.Reserve(100);
+  EXPECT_EQ(cache.capacity(), 200);
+  cache.Reserve(300);
+  EXPECT_EQ(cache.capacity(), 300);
+  cache.Insert("a", Image(1));
+  EXPECT_TRUE(cache.Lookup("a", &image));
+}
+
+}  // namespace caffe
+#endif  // USE_OPENCV
@@ -10,6 +10,7 @@
 #include "caffe/filler.hpp"
 #include "caffe/layers/image_data_layer.hpp"
 #include "caffe/proto/caffe.pb.h"
+#include "caffe/util/image_cache.hpp"
 #include "caffe/util/io.hpp"
 
 #include "caffe/test/test_caffe_main.hpp"
@@ -143,6 +144,47 @@ TYPED_TEST(ImageDataLayerTest, TestReshape) {
   EXPECT_EQ(this->blob_top_data_->width(), 481);
 }
 
+TYPED_TEST(ImageDataLayerTest, TestReadCached) {
+  typedef typename TypeParam::Dtype Dtype;
+  LayerParameter param;
+  ImageDataParameter* image_data_param = param.mutable_image_data_param();
+  image_data_param->set_batch_size(5);
+  image_data_param->set_source(this->filename_.c_str());
+  image_data_param->set_new_height(64);
+  image_data_param->set_new_width(48);
+  image_data_param->set_shuffle(false);
+  ImageDataLayer<Dtype> uncached_layer(param);
+  Blob<Dtype> uncached_data, uncached_label;
+  vector<Blob<Dtype>*> uncached_top_vec;
+  uncached_top_vec.push_back(&uncached_data);
+  uncached_top_vec.push_back(&uncached_label);
+  uncached_layer.SetUp(this->blob_bottom_vec_, uncached_top_vec);
+  ImageCache& cache = ImageCache::Get();
+  cache.Clear();
+  image_data_param->set_cache_size_mb(1);
+  ImageDataLayer<Dtype> layer(param);
+  layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+  EXPECT_GE(cache.capacity(), 1 << 20);
+  // Go through the data twice
+  for (int iter = 0; iter < 2; ++iter) {
+    uncached_layer.Forward(this->blob_bottom_vec_, uncached_top_vec);
+    layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+    ASSERT_EQ(uncached_data.count(), this->blob_top_data_->count());
+    for (int i = 0; i < uncached_data.count(); ++i) {
+      EXPECT_EQ(uncached_data.cpu_data()[i],
+          this->blob_top_data_->cpu_data()[i]);
+    }
+    for (int i = 0; i < 5; ++i) {
+      EXPECT_EQ(i, this->blob_top_label_->cpu_data()[i]);
+    }
+  }
+  // All five lines name the same image, so it is decoded only once.
+  EXPECT_EQ(cache.size(), 64 * 48 * 3);
+  EXPECT_EQ(cache.misses(), 1);
+  EXPECT_GE(cache.hits(), 10);
+  cache.Clear();
+}
+
 TYPED_TEST(ImageDataLayerTest, TestShuffle) {
   typedef typename TypeParam::Dtype Dtype;
   LayerParameter param;
@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <fstream>  // NOLINT(readability/streams)
+#include <iterator>
+#include <map>
 #include <string>
 #include <utility>
 #include <vector>
@@ -9,6 +13,7 @@
 #include "caffe/common.hpp"
 #include "caffe/filler.hpp"
 #include "caffe/net.hpp"
+#include "caffe/util/io.hpp"
 #include "caffe/util/math_functions.hpp"
 
 #include "caffe/test/test_caffe_main.hpp"
@@ -2331,6 +2336,274 @@ TYPED_TEST(NetTest, TestReshape) {
   EXPECT_FALSE(same_spatial_shape);
 }
 
+TYPED_TEST(NetTest, TestShareActivations) {
+  typedef typename TypeParam::Dtype Dtype;
+  // pool1 feeds both conv2 and the sum (through a split), so it has to stay
+  // alive until the sum while conv1 and conv2 may share memory.
+  const string& proto =
+      "input: 'data' "
+      "input_shape { dim: 2 dim: 3 dim: 8 dim: 8 } "
+      "layer { "
+      "  name: 'conv1' type: 'Convolution' bottom: 'data' top: 'conv1' "
+      "  convolution_param { num_output: 4 kernel_size: 3 pad: 1 "
+      "    weight_filler { type: 'gaussian' std: 0.1 } } "
+      "} "
+      "layer { name: 'relu1' type: 'ReLU' bottom: 'conv1' top: 'conv1' } "
+      "layer { "
+      "  name: 'pool1' type: 'Pooling' bottom: 'conv1' top: 'pool1' "
+      "  pooling_param { pool: MAX kernel_size: 2 stride: 2 } "
+      "} "
+      "layer { "
+      "  name: 'conv2' type: 'Convolution' bottom: 'pool1' top: 'conv2' "
+      "  convolution_param { num_output: 4 kernel_size: 3 pad: 1 "
+      "    weight_filler { type: 'gaussian' std: 0.1 } } "
+      "} "
+      "layer { "
+      "  name: 'sum' type: 'Eltwise' bottom: 'pool1' bottom: 'conv2' "
+      "  top: 'sum' "
+      "} "
+      "layer { "
+      "  name: 'conv3' type: 'Convolution' bottom: 'sum' top: 'conv3' "
+      "  convolution_param { num_output: 4 kernel_size: 3 pad: 1 "
+      "    weight_filler { type: 'gaussian' std: 0.1 } } "
+      "} "
+      "layer { "
+      "  name: 'ip' type: 'InnerProduct' bottom: 'conv3' top: 'ip' "
+      "  inner_product_param { num_output: 5 "
+      "    weight_filler { type: 'gaussian' std: 0.1 } } "
+      "} ";
+  NetParameter param;
+  CHECK(google::protobuf::TextFormat::ParseFromString(proto, &param));
+  Net<Dtype> net(param);
+  param.set_share_activations(true);
+  Net<Dtype> shared_net(param);
+  shared_net.ShareTrainedLayersWith(&net);
+  EXPECT_EQ(shared_net.blob_by_name("conv1")->data(),
+            shared_net.blob_by_name("conv2")->data());
+  EXPECT_NE(shared_net.blob_by_name("pool1")->data(),
+            shared_net.blob_by_name("conv2")->data());
+  EXPECT_NE(shared_net.blob_by_name("data")->data(),
+            shared_net.blob_by_name("conv1")->data());
+  FillerParameter filler_param;
+  GaussianFiller<Dtype> filler(filler_param);
+  filler.Fill(net.input_blobs()[0]);
+  shared_net.input_blobs()[0]->CopyFrom(*net.input_blobs()[0]);
+  for (int i = 0; i < 3; ++i) {
+    if (i == 2) {
+      // A larger batch grows the blobs out of their buffers; Reshape plans
+      // the sharing again.
+      net.input_blobs()[0]->Reshape(4, 3, 8, 8);
+      net.Reshape();
+      filler.Fill(net.input_blobs()[0]);
+      shared_net.input_blobs()[0]->ReshapeLike(*net.input_blobs()[0]);
+      shared_net.Reshape();
+      shared_net.input_blobs()[0]->CopyFrom(*net.input_blobs()[0]);
+      EXPECT_EQ(shared_net.blob_by_name("conv1")->data(),
+                shared_net.blob_by_name("conv2")->data());
+      EXPECT_NE(shared_net.blob_by_name("pool1")->data(),
+                shared_net.blob_by_name("conv2")->data());
+      // Every buffer is as large as the largest blob in it, no larger.
+      map<SyncedMemory*, size_t> largest;
+      const vector<shared_ptr<Blob<Dtype> > >& blobs = shared_net.blobs();
+      for (int j = 0; j < blobs.size(); ++j) {
+        size_t& bytes = largest[blobs[j]->data().get()];
+        bytes = std::max(bytes, blobs[j]->count() * sizeof(Dtype));
+      }
+      for (map<SyncedMemory*, size_t>::const_iterator it = largest.begin();
+           it != largest.end(); ++it) {
+        EXPECT_EQ(it->first->size(), it->second);
+      }
+    }
+    net.ForwardPrefilled();
+    shared_net.ForwardPrefilled();
+    const Blob<Dtype>* output = net.output_blobs()[0];
+    const Blob<Dtype>* shared_output = shared_net.output_blobs()[0];
+    ASSERT_EQ(output->count(), shared_output->count());
+    for (int j = 0; j < output->count(); ++j) {
+      EXPECT_EQ(output->cpu_data()[j], shared_output->cpu_data()[j]);
+    }
+  }
+}
+
+TYPED_TEST(NetTest, TestContiguousParams) {
+  typedef typename TypeParam::Dtype Dtype;
+  // ip1 and ip2 share their weights; ip2 has a bias of its own.
+  const string& proto =
+      "state { phase: TRAIN } "
+      "layer { "
+      "  name: 'data' type: 'DummyData' top: 'data' top: 'target' "
+      "  dummy_data_param { shape { dim: 5 dim: 6 } shape { dim: 5 dim: 4 } "
+      "    data_filler { type: 'gaussian' } } "
+      "} "
+      "layer { "
+      "  name: 'ip1' type: 'InnerProduct' bottom: 'data' top: 'ip1' "
+      "  inner_product_param { num_output: 6 bias_term: false "
+      "    weight_filler { type: 'gaussian' std: 0.1 } } "
+      "  param { name: 'shared' } "
+      "} "
+      "layer { "
+      "  name: 'ip2' type: 'InnerProduct' bottom: 'ip1' top: 'ip2' "
+      "  inner_product_param { num_output: 6 "
+      "    weight_filler { type: 'gaussian' std: 0.1 } "
+      "    bias_filler { type: 'gaussian' std: 0.1 } } "
+      "  param { name: 'shared' } "
+      "} "
+      "layer { "
+      "  name: 'ip3' type: 'InnerProduct' bottom: 'ip2' top: 'ip3' "
+      "  inner_product_param { num_output: 4 "
+      "    weight_filler { type: 'gaussian' std: 0.1 } } "
+      "} "
+      "layer { "
+      "  name: 'loss' type: 'EuclideanLoss' bottom: 'ip3' bottom: 'target' "
+      "} ";
+  NetParameter param;
+  CHECK(google::protobuf::TextFormat::ParseFromString(proto, &param));
+  Caffe::set_random_seed(this->seed_);
+  Net<Dtype> net(param);
+  param.set_contiguous_params(true);
+  Caffe::set_random_seed(this->seed_);
+  Net<Dtype> flat_net(param);
+  EXPECT_FALSE(net.flat_params());
+  if (Caffe::mode() != Caffe::CPU) {
+    EXPECT_FALSE(flat_net.flat_params());
+    return;
+  }
+  const vector<Blob<Dtype>*>& params = flat_net.learnable_params();
+  ASSERT_EQ(params.size(), 4);
+  const Blob<Dtype>& flat_params = *flat_net.flat_params();
+  int offset = 0;
+  for (int i = 0; i < params.size(); ++i) {
+    EXPECT_EQ(params[i]->cpu_data(), flat_params.cpu_data() + offset);
+    EXPECT_EQ(params[i]->cpu_diff(), flat_params.cpu_diff() + offset);
+    offset += params[i]->count();
+  }
+  EXPECT_EQ(offset, flat_params.count());
+  EXPECT_EQ(flat_net.layer_by_name("ip2")->blobs()[0]->cpu_data(),
+            flat_params.cpu_data());
+  // Both nets train alike, on the same random data.
+  vector<Blob<Dtype>*> bottom;
+  Net<Dtype>* nets[] = { &net, &flat_net };
+  for (int n = 0; n < 2; ++n) {
+    Caffe::set_random_seed(this->seed_);
+    for (int iter = 0; iter < 2; ++iter) {
+      nets[n]->ClearParamDiffs();
+      nets[n]->ForwardBackward(bottom);
+      nets[n]->Update();
+    }
+  }
+  for (int i = 0; i < params.size(); ++i) {
+    const Blob<Dtype>& expected = *net.learnable_params()[i];
+    for (int j = 0; j < expected.count(); ++j) {
+      EXPECT_EQ(expected.cpu_data()[j], params[i]->cpu_data()[j]);
+      EXPECT_EQ(expected.cpu_diff()[j], params[i]->cpu_diff()[j]);
+    }
+  }
+}
+
+TYPED_TEST(NetTest, TestContiguousParamsWinograd) {
+  typedef typename TypeParam::Dtype Dtype;
+  // Winograd caches its transformed filters, which must follow the updates
+  // written through the flat params.
+  const string& proto =
+      "state { phase: TRAIN } "
+      "contiguous_params: true "
+      "force_backward: true "
+      "input: 'data' "
+      "input_shape { dim: 1 dim: 2 dim: 6 dim: 6 } "
+      "layer { "
+      "  name: 'conv' type: 'Convolution' bottom: 'data' top: 'conv' "
+      "  convolution_param { num_output: 3 kernel_size: 3 engine: WINOGRAD "
+      "    bias_term: false weight_filler { type: 'gaussian' std: 0.1 } } "
+      "} ";
+  NetParameter param;
+  CHECK(google::protobuf::TextFormat::ParseFromString(proto, &param));
+  Net<Dtype> net(param);
+  if (!net.flat_params()) {
+    return;
+  }
+  FillerParameter filler_param;
+  GaussianFiller<Dtype> filler(filler_param);
+  filler.Fill(net.input_blobs()[0]);
+  net.ForwardPrefilled();
+  const Blob<Dtype>& top = *net.output_blobs()[0];
+  vector<Dtype> before(top.cpu_data(), top.cpu_data() + top.count());
+  caffe_set(net.flat_params()->count(), Dtype(-1),
+            net.flat_params()->mutable_cpu_diff());
+  net.Update();
+  net.ForwardPrefilled();
+  // Every filter tap grew by one, so some output has to change.
+  int changed = 0;
+  for (int i = 0; i < top.count(); ++i) {
+    changed += top.cpu_data()[i] != before[i];
+  }
+  EXPECT_GT(changed, 0);
+}
+
+TYPED_TEST(NetTest, TestProfiling) {
+  typedef typename TypeParam::Dtype Dtype;
+  const string& proto =
+      "force_backward: true "
+      "input: 'data' "
+      "input_shape { dim: 2 dim: 3 dim: 5 dim: 5 } "
+      "layer { "
+      "  name: 'conv' type: 'Convolution' bottom: 'data' top: 'conv' "
+      "  convolution_param { num_output: 4 kernel_size: 3 } "
+      "} "
+      "layer { "
+      "  name: 'ip' type: 'InnerProduct' bottom: 'conv' top: 'ip' "
+      "  inner_product_param { num_output: 2 } "
+      "} ";
+  NetParameter param;
+  CHECK(google::protobuf::TextFormat::ParseFromString(proto, &param));
+  Net<Dtype> net(param);
+  EXPECT_TRUE(net.profiler() == NULL);
+  net.set_profiling(true);
+  ASSERT_TRUE(net.profiler() != NULL);
+  for (int i = 0; i < 2; ++i) {
+    net.ForwardPrefilled();
+    net.Backward();
+  }
+  const vector<Profiler::LayerStats>& stats = net.profiler()->layer_stats();
+  ASSERT_EQ(stats.size(), 2);
+  EXPECT_EQ(stats[0].name, "conv");
+  EXPECT_EQ(stats[0].type, "Convolution");
+  EXPECT_EQ(stats[0].forward_calls, 2);
+  EXPECT_EQ(stats[0].backward_calls, 2);
+  EXPECT_EQ(stats[1].forward_calls, 2);
+  // Two calls of a multiply-add per 3x3x3 filter tap and 2x4x3x3 output.
+  EXPECT_EQ(stats[0].forward_flops, 2 * 2 * (2 * 4 * 3 * 3) * (3 * 3 * 3));
+  EXPECT_EQ(stats[1].forward_flops, 2 * 2 * (2 * 2) * (4 * 3 * 3));
+  string filename;
+  MakeTempFilename(&filename);
+  net.profiler()->WriteChromeTrace(filename);
+  std::ifstream file(filename.c_str());
+  const string trace((std::istreambuf_iterator<char>(file)),
+      std::istreambuf_iterator<char>());
+  EXPECT_EQ(trace.find("{\"traceEvents\":["), 0);
+  EXPECT_NE(trace.find("\"name\":\"conv\""), string::npos);
+  int num_events = 0;
+  for (size_t pos = trace.find("\"ph\":\"X\""); pos != string::npos;
+       pos = trace.find("\"ph\":\"X\"", pos + 1)) {
+    ++num_events;
+  }
+  EXPECT_EQ(num_events, 8);
+  // Layer names are escaped into valid JSON strings.
+  Profiler escaping(vector<string>(1, "a\"b\\c\td\n"),
+      vector<string>(1, "Type"));
+  escaping.LayerBegin();
+  escaping.LayerEnd(0, true, 0, 0);
+  escaping.WriteChromeTrace(filename);
+  std::ifstream escaped_file(filename.c_str());
+  const string escaped_trace((std::istreambuf_iterator<char>(escaped_file)),
+      std::istreambuf_iterator<char>());
+  EXPECT_NE(escaped_trace.find("\"name\":\"a\\\"b\\\\c\\u0009d\\u000a\""),
+      string::npos);
+  net.profiler()->Reset();
+  EXPECT_EQ(net.profiler()->layer_stats()[0].forward_calls, 0);
+  net.set_profiling(false);
+  EXPECT_TRUE(net.profiler() == NULL);
+}
+
 TYPED_TEST(NetTest, TestSkipPropagateDown) {
   // check bottom_need_backward if propagate_down is true
   this->InitSkipPropNet(false);
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cfloat>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -609,6 +611,57 @@ TYPED_TEST(PoolingLayerTest, TestGradientAvePadded) {
   }
 }
 
+TYPED_TEST(PoolingLayerTest, TestForwardStride2Threaded) {
+  typedef typename TypeParam::Dtype Dtype;
+  // 2x2 and 3x3 stride 2 pooling takes the unrolled path for the interior
+  // windows and the generic one for the clipped border; check both against a
+  // direct computation, with the planes split across threads.
+  const int threads = Caffe::cpu_threads();
+  Caffe::set_cpu_threads(2);
+  for (int kernel = 2; kernel <= 3; ++kernel) {
+    for (int method = 0; method <= 1; ++method) {
+      LayerParameter layer_param;
+      PoolingParameter* pooling_param = layer_param.mutable_pooling_param();
+      pooling_param->set_kernel_size(kernel);
+      pooling_param->set_stride(2);
+      pooling_param->set_num_threads(2);
+      pooling_param->set_pool(method == 0 ? PoolingParameter_PoolMethod_MAX :
+          PoolingParameter_PoolMethod_AVE);
+      PoolingLayer<Dtype> layer(layer_param);
+      layer.SetUp(this->blob_bottom_vec_, this->blob_top_vec_);
+      layer.Forward(this->blob_bottom_vec_, this->blob_top_vec_);
+      const int height = this->blob_bottom_->height();
+      const int width = this->blob_bottom_->width();
+      const int pooled_height = this->blob_top_->height();
+      const int pooled_width = this->blob_top_->width();
+      for (int n = 0; n < this->blob_bottom_->num(); ++n) {
+        for (int c = 0; c < this->blob_bottom_->channels(); ++c) {
+          for (int ph = 0; ph < pooled_height; ++ph) {
+            for (int pw = 0; pw < pooled_width; ++pw) {
+              const int hend = std::min(ph * 2 + kernel, height);
+              const int wend = std::min(pw * 2 + kernel, width);
+              Dtype expected = method == 0 ? -FLT_MAX : 0;
+              for (int h = ph * 2; h < hend; ++h) {
+                for (int w = pw * 2; w < wend; ++w) {
+                  const Dtype value = this->blob_bottom_->data_at(n, c, h, w);
+                  expected = method == 0 ? std::max(expected, value) :
+                      expected + value;
+                }
+              }
+              if (method == 1) {
+                expected /= (hend - ph * 2) * (wend - pw * 2);
+              }
+              EXPECT_NEAR(this->blob_top_->data_at(n, c, ph, pw), expected,
+                  1e-5);
+            }
+          }
+        }
+      }
+    }
+  }
+  Caffe::set_cpu_threads(threads);
+}
+
 #ifdef USE_CUDNN
 template <typename Dtype>
 class CuDNNPoolingLayerTest : public GPUDeviceTest<Dtype> {
@@ -106,4 +106,33 @@ TYPED_TEST(SolverTest, TestInitTrainTestNets) {
   EXPECT_TRUE(this->solver_->test_nets()[1]->has_layer("accuracy"));
 }
 
+TYPED_TEST(SolverTest, TestProfilingWithoutInterval) {
+  // Profiling turned on through the net, with no profile_interval to report
+  // at, only collects.
+  const string& proto =
+     "base_lr: 0.01 "
+     "lr_policy: 'fixed' "
+     "net_param { "
+     "  name: 'TestNetwork' "
+     "  layer { "
+     "    name: 'data' type: 'DummyData' top: 'data' top: 'label' "
+     "    dummy_data_param { shape { dim: 5 dim: 2 } shape { dim: 5 } } "
+     "  } "
+     "  layer { "
+     "    name: 'innerprod' type: 'InnerProduct' bottom: 'data' "
+     "    top: 'innerprod' inner_product_param { num_output: 3 } "
+     "  } "
+     "  layer { "
+     "    name: 'loss' type: 'SoftmaxWithLoss' bottom: 'innerprod' "
+     "    bottom: 'label' "
+     "  } "
+     "} ";
+  this->InitSolverFromProtoString(proto);
+  this->solver_->net()->set_profiling(true);
+  this->solver_->Step(2);
+  EXPECT_EQ(this->solver_->iter(), 2);
+  EXPECT_EQ(this->solver_->net()->profiler()->layer_stats()[1].forward_calls,
+            2);
+}
+
 }  // namespace caffe
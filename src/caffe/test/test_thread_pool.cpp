@@ -0,0 +1,93 @@
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "caffe/common.hpp"
+#include "caffe/util/thread_pool.hpp"
+
+#include "caffe/test/test_caffe_main.hpp"
+
+namespace caffe {
+
+class ThreadPoolTest : public ::testing::Test {};
+
+// Counts how often each iteration of a range is visited.
+class CountVisits {
+ public:
+  explicit CountVisits(vector<int>* visits) : visits_(visits) {}
+  void operator()(int begin, int end) const {
+    for (int i = begin; i < end; ++i) {
+      ++(*visits_)[i];
+    }
+  }
+ private:
+  vector<int>* visits_;
+};
+
+// Runs a nested parallel_for over each row of a rows x cols grid.
+class CountRowVisits {
+ public:
+  CountRowVisits(vector<int>* visits, int cols)
+      : visits_(visits), cols_(cols) {}
+  void operator()(int begin, int end) const {
+    for (int row = begin; row < end; ++row) {
+      vector<int> row_visits(cols_, 0);
+      parallel_for(0, cols_, CountVisits(&row_visits));
+      for (int col = 0; col < cols_; ++col) {
+        (*visits_)[row * cols_ + col] += row_visits[col];
+      }
+    }
+  }
+ private:
+  vector<int>* visits_;
+  int cols_;
+};
+
+TEST_F(ThreadPoolTest, TestVisitsEachIterationOnce) {
+  ThreadPool pool(4);
+  EXPECT_EQ(4, pool.num_threads());
+  for (int grain = 1; grain <= 64; grain *= 4) {
+    vector<int> visits(1000, 0);
+    pool.Run(0, visits.size(), grain, CountVisits(&visits));
+    for (int i = 0; i < visits.size(); ++i) {
+      EXPECT_EQ(1, visits[i]) << "iteration " << i << ", grain " << grain;
+    }
+  }
+}
+
+TEST_F(ThreadPoolTest, TestSubRange) {
+  ThreadPool pool(3);
+  vector<int> visits(100, 0);
+  pool.Run(10, 90, 7, CountVisits(&visits));
+  pool.Run(50, 50, 1, CountVisits(&visits));
+  for (int i = 0; i < visits.size(); ++i) {
+    EXPECT_EQ(i >= 10 && i < 90 ? 1 : 0, visits[i]);
+  }
+}
+
+TEST_F(ThreadPoolTest, TestResize) {
+  ThreadPool pool(1);
+  EXPECT_EQ(1, pool.num_threads());
+  pool.Resize(2);
+  EXPECT_EQ(2, pool.num_threads());
+  vector<int> visits(10, 0);
+  pool.Run(0, visits.size(), 1, CountVisits(&visits));
+  for (int i = 0; i < visits.size(); ++i) {
+    EXPECT_EQ(1, visits[i]);
+  }
+}
+
+TEST_F(ThreadPoolTest, TestNestedParallelFor) {
+  const int threads = Caffe::cpu_threads();
+  Caffe::set_cpu_threads(4);
+  EXPECT_EQ(4, Caffe::cpu_threads());
+  const int rows = 17, cols = 13;
+  vector<int> visits(rows * cols, 0);
+  parallel_for(0, rows, CountRowVisits(&visits, cols));
+  for (int i = 0; i < visits.size(); ++i) {
+    EXPECT_EQ(1, visits[i]);
+  }
+  Caffe::set_cpu_threads(threads);
+}
+
+}  // namespace caffe
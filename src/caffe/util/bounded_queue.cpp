@@ -0,0 +1,257 @@
+#include <boost/atomic.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/thread.hpp>
+#include <stdint.h>
+
+#include "caffe/layers/base_data_layer.hpp"
+#include "caffe/util/bounded_queue.hpp"
+
+namespace caffe {
+
+// How many times push and pop retry before they go to sleep; a few yields
+// cover the other side being just about to make room or an item.
+static const int kBoundedQueueSpins = 16;
+
+// Keeps the ends of the ring on separate cache lines, so that producers and
+// consumers don't invalidate each other's line on every operation.
+static const int kCacheLineSize = 64;
+
+template<typename T>
+class BoundedQueue<T>::ring {
+ public:
+  explicit ring(int capacity);
+
+  bool try_push(const T& t);
+  bool try_pop(T* t);
+  bool try_peek(T* t) const;
+  size_t size() const;
+  // Wakes the threads asleep in wait, if any, after a push or pop.
+  void notify();
+
+  // Blocks until try_op(t) succeeds.
+  template<typename Op, typename Arg>
+  void wait(Op op, Arg t, const char* log_on_wait);
+
+  struct slot {
+    boost::atomic<size_t> sequence;
+    T value;
+  };
+
+  const size_t mask_;
+  boost::scoped_array<slot> slots_;
+  char pad0_[kCacheLineSize];
+  boost::atomic<size_t> push_position_;
+  char pad1_[kCacheLineSize];
+  boost::atomic<size_t> pop_position_;
+  char pad2_[kCacheLineSize];
+  boost::atomic<int> waiting_;
+  boost::mutex mutex_;
+  boost::condition_variable condition_;
+};
+
+// A single slot would read the same for the pop that emptied it and the
+// push that refills it, so the ring has at least two.
+static size_t RoundUpToPowerOfTwo(int capacity) {
+  CHECK_GT(capacity, 0) << "A bounded queue needs room for an item.";
+  size_t size = 2;
+  while (size < static_cast<size_t>(capacity)) {
+    size <<= 1;
+  }
+  return size;
+}
+
+template<typename T>
+BoundedQueue<T>::ring::ring(int capacity)
+    : mask_(RoundUpToPowerOfTwo(capacity) - 1),
+      slots_(new slot[mask_ + 1]), push_position_(0), pop_position_(0),
+      waiting_(0) {
+  // A slot is free for the push at position p when its sequence is p, and
+  // holds the item for the pop at p when it is p + 1.
+  for (size_t i = 0; i <= mask_; ++i) {
+    slots_[i].sequence.store(i, boost::memory_order_relaxed);
+  }
+}
+
+template<typename T>
+bool BoundedQueue<T>::ring::try_push(const T& t) {
+  size_t position = push_position_.load(boost::memory_order_relaxed);
+  slot* s;
+  while (true) {
+    s = &slots_[position & mask_];
+    const intptr_t turn = static_cast<intptr_t>(
+        s->sequence.load(boost::memory_order_acquire) - position);
+    if (turn == 0) {
+      if (push_position_.compare_exchange_weak(position, position + 1,
+          boost::memory_order_relaxed)) {
+        break;
+      }
+    } else if (turn < 0) {
+      // The slot still holds the item pushed a lap ago: the ring is full.
+      return false;
+    } else {
+      position = push_position_.load(boost::memory_order_relaxed);
+    }
+  }
+  s->value = t;
+  s->sequence.store(position + 1, boost::memory_order_release);
+  return true;
+}
+
+template<typename T>
+bool BoundedQueue<T>::ring::try_pop(T* t) {
+  size_t position = pop_position_.load(boost::memory_order_relaxed);
+  slot* s;
+  while (true) {
+    s = &slots_[position & mask_];
+    const intptr_t turn = static_cast<intptr_t>(
+        s->sequence.load(boost::memory_order_acquire) - (position + 1));
+    if (turn == 0) {
+      if (pop_position_.compare_exchange_weak(position, position + 1,
+          boost::memory_order_relaxed)) {
+        break;
+      }
+    } else if (turn < 0) {
+      // Nothing pushed to this slot yet: the ring is empty.
+      return false;
+    } else {
+      position = pop_position_.load(boost::memory_order_relaxed);
+    }
+  }
+  *t = s->value;
+  // Free the slot for the push one lap later.
+  s->sequence.store(position + mask_ + 1, boost::memory_order_release);
+  return true;
+}
+
+template<typename T>
+bool BoundedQueue<T>::ring::try_peek(T* t) const {
+  const size_t position = pop_position_.load(boost::memory_order_relaxed);
+  const slot& s = slots_[position & mask_];
+  if (s.sequence.load(boost::memory_order_acquire) != position + 1) {
+    return false;
+  }
+  *t = s.value;
+  return true;
+}
+
+template<typename T>
+size_t BoundedQueue<T>::ring::size() const {
+  // Count the pushes that completed, rather than those that started.
+  const size_t position = pop_position_.load(boost::memory_order_acquire);
+  size_t count = 0;
+  while (count <= mask_ && slots_[(position + count) & mask_].sequence.load(
+      boost::memory_order_acquire) == position + count + 1) {
+    ++count;
+  }
+  return count;
+}
+
+template<typename T>
+void BoundedQueue<T>::ring::notify() {
+  // Pairs with the fence in wait: either the waiter sees the slot this
+  // thread just changed, or this thread sees the waiter.
+  boost::atomic_thread_fence(boost::memory_order_seq_cst);
+  if (waiting_.load(boost::memory_order_relaxed) > 0) {
+    boost::mutex::scoped_lock lock(mutex_);
+    condition_.notify_all();
+  }
+}
+
+template<typename T>
+template<typename Op, typename Arg>
+void BoundedQueue<T>::ring::wait(Op op, Arg t, const char* log_on_wait) {
+  for (int i = 0; i < kBoundedQueueSpins; ++i) {
+    boost::this_thread::yield();
+    if ((this->*op)(t)) {
+      return;
+    }
+  }
+  if (log_on_wait) {
+    LOG_EVERY_N(INFO, 1000) << log_on_wait;
+  }
+  boost::mutex::scoped_lock lock(mutex_);
+  waiting_.fetch_add(1, boost::memory_order_relaxed);
+  boost::atomic_thread_fence(boost::memory_order_seq_cst);
+  try {
+    while (!(this->*op)(t)) {
+      condition_.wait(lock);
+    }
+  } catch (...) {
+    // Interrupted while waiting.
+    waiting_.fetch_sub(1, boost::memory_order_relaxed);
+    throw;
+  }
+  waiting_.fetch_sub(1, boost::memory_order_relaxed);
+}
+
+template<typename T>
+BoundedQueue<T>::BoundedQueue(int capacity)
+    : ring_(new ring(capacity)) {
+}
+
+template<typename T>
+void BoundedQueue<T>::push(const T& t) {
+  if (!ring_->try_push(t)) {
+    ring_->wait(&ring::try_push, t, NULL);
+  }
+  ring_->notify();
+}
+
+template<typename T>
+bool BoundedQueue<T>::try_push(const T& t) {
+  if (!ring_->try_push(t)) {
+    return false;
+  }
+  ring_->notify();
+  return true;
+}
+
+template<typename T>
+T BoundedQueue<T>::pop(const char* log_on_wait) {
+  T t;
+  if (!ring_->try_pop(&t)) {
+    ring_->wait(&ring::try_pop, &t, log_on_wait);
+  }
+  ring_->notify();
+  return t;
+}
+
+template<typename T>
+bool BoundedQueue<T>::try_pop(T* t) {
+  if (!ring_->try_pop(t)) {
+    return false;
+  }
+  ring_->notify();
+  return true;
+}
+
+template<typename T>
+T BoundedQueue<T>::peek() {
+  T t;
+  if (!ring_->try_peek(&t)) {
+    ring_->wait(&ring::try_peek, &t, NULL);
+  }
+  return t;
+}
+
+template<typename T>
+bool BoundedQueue<T>::try_peek(T* t) {
+  return ring_->try_peek(t);
+}
+
+template<typename T>
+size_t BoundedQueue<T>::size() const {
+  return ring_->size();
+}
+
+template<typename T>
+size_t BoundedQueue<T>::capacity() const {
+  return ring_->mask_ + 1;
+}
+
+template class BoundedQueue<Batch<float>*>;
+template class BoundedQueue<Batch<double>*>;
+template class BoundedQueue<int>;
+template class BoundedQueue<Datum*>;
+
+}  // namespace caffe
@@ -0,0 +1,240 @@
+#include "caffe/util/db_record.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace caffe { namespace db {
+
+static const char kRecordMagic[8] = { 'C', 'A', 'F', 'F', 'E', 'R', 'E', 'C' };
+static const uint32_t kRecordVersion = 1;
+
+struct RecordFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t num_records;
+  uint64_t index_offset;
+};
+
+enum RecordPayload { RAW = 0, ENCODED = 1, FLOAT = 2 };
+
+struct RecordHeader {
+  uint32_t key_size;
+  int32_t label;
+  int32_t channels;
+  int32_t height;
+  int32_t width;
+  uint32_t payload;
+  uint64_t payload_size;
+};
+
+// Records start at multiples of this, so that their headers are aligned.
+static const uint64_t kRecordAlignment = 8;
+
+static inline const RecordHeader& GetHeader(const char* record) {
+  return *reinterpret_cast<const RecordHeader*>(record);
+}
+
+static inline const char* GetKey(const char* record) {
+  return record + sizeof(RecordHeader);
+}
+
+static inline const char* GetPayload(const char* record) {
+  return GetKey(record) + GetHeader(record).key_size;
+}
+
+static inline bool KeyLess(const char* record, const string& key) {
+  const size_t key_size = GetHeader(record).key_size;
+  const int order = memcmp(GetKey(record), key.data(),
+      std::min(key_size, key.size()));
+  return order < 0 || (order == 0 && key_size < key.size());
+}
+
+void RecordCursor::Seek(const string& key) {
+  size_t begin = 0, end = num_records_;
+  while (begin < end) {
+    const size_t middle = begin + (end - begin) / 2;
+    if (KeyLess(record(middle), key)) {
+      begin = middle + 1;
+    } else {
+      end = middle;
+    }
+  }
+  position_ = begin;
+}
+
+string RecordCursor::key() {
+  const char* current = record(position_);
+  return string(GetKey(current), GetHeader(current).key_size);
+}
+
+string RecordCursor::value() {
+  Datum datum;
+  ParseDatum(&datum);
+  string value;
+  CHECK(datum.SerializeToString(&value));
+  return value;
+}
+
+const char* RecordCursor::value_data() {
+  if (value_position_ != position_) {
+    value_ = value();
+    value_position_ = position_;
+  }
+  return value_.data();
+}
+
+size_t RecordCursor::value_size() {
+  value_data();
+  return value_.size();
+}
+
+void RecordCursor::ParseDatum(Datum* datum) {
+  const char* current = record(position_);
+  const RecordHeader& header = GetHeader(current);
+  datum->Clear();
+  datum->set_channels(header.channels);
+  datum->set_height(header.height);
+  datum->set_width(header.width);
+  datum->set_label(header.label);
+  if (header.payload == FLOAT) {
+    const int count = header.payload_size / sizeof(float);
+    datum->mutable_float_data()->Resize(count, 0);
+    // The payload follows the unpadded key, so it may not be aligned for
+    // float; copy it bytewise.
+    memcpy(datum->mutable_float_data()->mutable_data(), GetPayload(current),
+        count * sizeof(float));
+  } else {
+    datum->set_data(GetPayload(current), header.payload_size);
+    datum->set_encoded(header.payload == ENCODED);
+  }
+}
+
+void RecordTransaction::Put(const string& key, const string& value) {
+  records_.push_back(make_pair(key, value));
+}
+
+void RecordTransaction::Commit() {
+  for (int i = 0; i < records_.size(); ++i) {
+    db_->Append(records_[i].first, records_[i].second);
+  }
+  records_.clear();
+}
+
+void RecordDB::Open(const string& source, Mode mode) {
+  if (mode == NEW) {
+    file_.open(source.c_str(), std::ios::out | std::ios::binary);
+    CHECK(file_.is_open()) << "Failed to create record file " << source;
+    // The header is written once the index is.
+    RecordFileHeader header = {};
+    file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    offset_ = sizeof(header);
+    offsets_.clear();
+    LOG(INFO) << "Created record file " << source;
+    return;
+  }
+  CHECK_EQ(mode, READ) << "Record files can only be created or read.";
+  const int fd = open(source.c_str(), O_RDONLY);
+  CHECK_GE(fd, 0) << "Failed to open record file " << source;
+  struct stat st;
+  CHECK_EQ(fstat(fd, &st), 0) << "Failed to stat record file " << source;
+  map_size_ = st.st_size;
+  CHECK_GE(map_size_, sizeof(RecordFileHeader)) << source
+      << " is not a record file.";
+  void* map = mmap(NULL, map_size_, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  CHECK(map != MAP_FAILED) << "Failed to map record file " << source;
+  map_ = static_cast<char*>(map);
+  const RecordFileHeader& header =
+      *reinterpret_cast<const RecordFileHeader*>(map_);
+  CHECK_EQ(memcmp(header.magic, kRecordMagic, sizeof(kRecordMagic)), 0)
+      << source << " is not a record file.";
+  CHECK_EQ(header.version, kRecordVersion) << "Unsupported version of "
+      << "record file " << source;
+  CHECK_LE(header.index_offset + header.num_records * sizeof(uint64_t),
+      map_size_) << "Record file " << source << " is truncated.";
+  index_ = reinterpret_cast<const uint64_t*>(map_ + header.index_offset);
+  num_records_ = header.num_records;
+  LOG(INFO) << "Opened record file " << source << " of " << num_records_
+      << " records";
+}
+
+void RecordDB::Close() {
+  if (map_ != NULL) {
+    munmap(map_, map_size_);
+    map_ = NULL;
+  }
+  if (file_.is_open()) {
+    // Write the index, sorted by key, then the header that points at it.
+    std::stable_sort(offsets_.begin(), offsets_.end());
+    RecordFileHeader header = {};
+    std::copy(kRecordMagic, kRecordMagic + sizeof(kRecordMagic),
+        header.magic);
+    header.version = kRecordVersion;
+    header.num_records = offsets_.size();
+    header.index_offset = offset_;
+    for (int i = 0; i < offsets_.size(); ++i) {
+      file_.write(reinterpret_cast<const char*>(&offsets_[i].second),
+          sizeof(uint64_t));
+    }
+    file_.seekp(0);
+    file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file_.close();
+    CHECK(!file_.fail()) << "Failed to write record file.";
+    offsets_.clear();
+  }
+}
+
+RecordCursor* RecordDB::NewCursor() {
+  CHECK(map_) << "Record files are read through a cursor once written.";
+  return new RecordCursor(map_, index_, num_records_);
+}
+
+RecordTransaction* RecordDB::NewTransaction() {
+  CHECK(file_.is_open()) << "Record files are written when created.";
+  return new RecordTransaction(this);
+}
+
+void RecordDB::Append(const string& key, const string& value) {
+  Datum datum;
+  CHECK(datum.ParseFromString(value)) << "Record " << key
+      << " is not a Datum.";
+  RecordHeader header = {};
+  header.key_size = key.size();
+  header.label = datum.label();
+  header.channels = datum.channels();
+  header.height = datum.height();
+  header.width = datum.width();
+  const char* payload;
+  if (datum.float_data_size() > 0) {
+    header.payload = FLOAT;
+    header.payload_size = datum.float_data_size() * sizeof(float);
+    payload = reinterpret_cast<const char*>(datum.float_data().data());
+  } else {
+    header.payload = datum.encoded() ? ENCODED : RAW;
+    header.payload_size = datum.data().size();
+    payload = datum.data().data();
+  }
+  const uint64_t size = sizeof(header) + key.size() + header.payload_size;
+  const uint64_t padding = (kRecordAlignment - size % kRecordAlignment) %
+      kRecordAlignment;
+  const char zeros[kRecordAlignment] = {};
+  file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file_.write(key.data(), key.size());
+  file_.write(payload, header.payload_size);
+  file_.write(zeros, padding);
+  CHECK(!file_.fail()) << "Failed to write record " << key;
+  offsets_.push_back(make_pair(key, offset_));
+  offset_ += size + padding;
+}
+
+}  // namespace db
+}  // namespace caffe
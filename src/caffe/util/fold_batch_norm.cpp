@@ -0,0 +1,173 @@
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "caffe/blob.hpp"
+#include "caffe/common.hpp"
+#include "caffe/util/fold_batch_norm.hpp"
+#include "caffe/util/math_functions.hpp"
+
+namespace caffe {
+
+// Whether the layer at index consumer can be merged into the one at
+// producer: nothing in between may touch the blob it reads, and unless it
+// works in-place nothing after it may read that blob either.
+static bool CanFold(const NetParameter& param, const vector<bool>& folded,
+    const int producer, const int consumer) {
+  const LayerParameter& layer_param = param.layer(consumer);
+  if (layer_param.bottom_size() != 1 || layer_param.top_size() != 1) {
+    return false;
+  }
+  const string& blob_name = layer_param.bottom(0);
+  const bool in_place = layer_param.top(0) == blob_name;
+  for (int i = producer + 1; i < param.layer_size(); ++i) {
+    if (folded[i] || i == consumer) { continue; }
+    const LayerParameter& other = param.layer(i);
+    for (int j = 0; j < other.bottom_size(); ++j) {
+      if (other.bottom(j) == blob_name && (i < consumer || !in_place)) {
+        return false;
+      }
+    }
+    for (int j = 0; i < consumer && j < other.top_size(); ++j) {
+      if (other.top(j) == blob_name) { return false; }
+    }
+  }
+  return true;
+}
+
+static bool UsesGlobalStats(const NetParameter& param,
+    const LayerParameter& layer_param) {
+  const BatchNormParameter& bn_param = layer_param.batch_norm_param();
+  if (bn_param.has_use_global_stats()) {
+    return bn_param.use_global_stats();
+  }
+  return param.state().phase() == TEST;
+}
+
+// Stores a folded blob in the precision the net's own blobs use.
+static void WriteFolded(const Blob<double>& blob, const bool double_data,
+    BlobProto* proto) {
+  // Clear the proto first: ToProto leaves the other precision's data in
+  // place, and FromProto would prefer double_data over the folded values.
+  proto->Clear();
+  if (double_data) {
+    blob.ToProto(proto);
+    return;
+  }
+  Blob<float> single(blob.shape());
+  float* single_data = single.mutable_cpu_data();
+  for (int i = 0; i < blob.count(); ++i) {
+    single_data[i] = blob.cpu_data()[i];
+  }
+  single.ToProto(proto);
+}
+
+// y = (x - mean) / sqrt(variance + eps) per output channel becomes a scale
+// of the channel's weights and bias. The arithmetic is done in double so
+// double nets keep their precision.
+static void FoldBatchNormInto(const LayerParameter& bn_param,
+    const int num_output, LayerParameter* layer_param, bool* has_bias) {
+  Blob<double> mean, variance, factor, weight, bias;
+  mean.FromProto(bn_param.blobs(0));
+  variance.FromProto(bn_param.blobs(1));
+  factor.FromProto(bn_param.blobs(2));
+  CHECK_EQ(mean.count(), num_output) << "BatchNorm layer " << bn_param.name()
+      << " has " << mean.count() << " channels where " << num_output
+      << " were expected.";
+  weight.FromProto(layer_param->blobs(0));
+  if (*has_bias) {
+    bias.FromProto(layer_param->blobs(1));
+  } else {
+    bias.Reshape(vector<int>(1, num_output));
+    caffe_set(num_output, 0., bias.mutable_cpu_data());
+  }
+  const double scale_factor = factor.cpu_data()[0] == 0 ?
+      0 : 1. / factor.cpu_data()[0];
+  const double eps = bn_param.batch_norm_param().eps();
+  const int dim = weight.count() / num_output;
+  double* weight_data = weight.mutable_cpu_data();
+  double* bias_data = bias.mutable_cpu_data();
+  for (int c = 0; c < num_output; ++c) {
+    const double scale =
+        1. / std::sqrt(variance.cpu_data()[c] * scale_factor + eps);
+    for (int i = 0; i < dim; ++i) {
+      weight_data[c * dim + i] *= scale;
+    }
+    bias_data[c] = (bias_data[c] - mean.cpu_data()[c] * scale_factor) * scale;
+  }
+  const bool double_data = layer_param->blobs(0).double_data_size() > 0;
+  WriteFolded(weight, double_data, layer_param->mutable_blobs(0));
+  if (!*has_bias) {
+    layer_param->add_blobs();
+    *has_bias = true;
+  }
+  WriteFolded(bias, double_data, layer_param->mutable_blobs(1));
+}
+
+void FoldBatchNorm(const NetParameter& param, NetParameter* param_folded) {
+  param_folded->CopyFrom(param);
+  param_folded->clear_layer();
+  vector<bool> folded(param.layer_size(), false);
+  vector<LayerParameter> layers(param.layer().begin(), param.layer().end());
+  for (int i = 0; i < layers.size(); ++i) {
+    if (folded[i]) { continue; }
+    LayerParameter* layer_param = &layers[i];
+    const bool is_conv = layer_param->type() == "Convolution";
+    int num_output;
+    bool has_bias;
+    if (is_conv) {
+      const ConvolutionParameter& conv_param =
+          layer_param->convolution_param();
+      if (conv_param.axis() != 1 || conv_param.fused_relu()) { continue; }
+      num_output = conv_param.num_output();
+      has_bias = conv_param.bias_term();
+    } else if (layer_param->type() == "InnerProduct") {
+      if (layer_param->inner_product_param().axis() != 1) { continue; }
+      num_output = layer_param->inner_product_param().num_output();
+      has_bias = layer_param->inner_product_param().bias_term();
+    } else {
+      continue;
+    }
+    if (layer_param->top_size() != 1 || layer_param->blobs_size() == 0) {
+      continue;
+    }
+    bool fused_relu = false;
+    for (int j = i + 1; j < layers.size() && !fused_relu; ++j) {
+      if (folded[j]) { continue; }
+      const LayerParameter& next = layers[j];
+      bool reads_top = false;
+      for (int k = 0; k < next.bottom_size(); ++k) {
+        reads_top |= next.bottom(k) == layer_param->top(0);
+      }
+      if (!reads_top) { continue; }
+      // The first reader of the top decides whether the chain goes on.
+      if (!CanFold(param, folded, i, j)) { break; }
+      if (next.type() == "BatchNorm" && next.blobs_size() == 3 &&
+          UsesGlobalStats(param, next)) {
+        FoldBatchNormInto(next, num_output, layer_param, &has_bias);
+        if (is_conv) {
+          layer_param->mutable_convolution_param()->set_bias_term(true);
+        } else {
+          layer_param->mutable_inner_product_param()->set_bias_term(true);
+        }
+      } else if (is_conv && next.type() == "ReLU" &&
+          next.relu_param().negative_slope() == 0) {
+        layer_param->mutable_convolution_param()->set_fused_relu(true);
+        fused_relu = true;
+      } else {
+        break;
+      }
+      LOG(INFO) << "Folding " << next.type() << " layer " << next.name()
+          << " into " << layer_param->name();
+      layer_param->set_top(0, next.top(0));
+      folded[j] = true;
+    }
+  }
+  for (int i = 0; i < layers.size(); ++i) {
+    if (!folded[i]) {
+      param_folded->add_layer()->CopyFrom(layers[i]);
+    }
+  }
+}
+
+}  // namespace caffe
@@ -1,15 +1,15 @@
 #include "caffe/util/hdf5.hpp"
 
+#include <boost/thread.hpp>
+#include <algorithm>
 #include <string>
 #include <vector>
 
 namespace caffe {
 
-// Verifies format of data stored in HDF5 file and reshapes blob accordingly.
-template <typename Dtype>
-void hdf5_load_nd_dataset_helper(
-    hid_t file_id, const char* dataset_name_, int min_dim, int max_dim,
-    Blob<Dtype>* blob) {
+// Verifies format of data stored in HDF5 file and returns its dimensions.
+static std::vector<hsize_t> hdf5_get_dataset_dims(
+    hid_t file_id, const char* dataset_name_, int min_dim, int max_dim) {
   // Verify that the dataset exists.
   CHECK(H5LTfind_dataset(file_id, dataset_name_))
       << "Failed to find HDF5 dataset " << dataset_name_;
@@ -55,7 +55,16 @@ void hdf5_load_nd_dataset_helper(
   default:
     LOG(FATAL) << "Datatype class unknown";
   }
+  return dims;
+}
 
+// Verifies format of data stored in HDF5 file and reshapes blob accordingly.
+template <typename Dtype>
+void hdf5_load_nd_dataset_helper(
+    hid_t file_id, const char* dataset_name_, int min_dim, int max_dim,
+    Blob<Dtype>* blob) {
+  const std::vector<hsize_t> dims =
+      hdf5_get_dataset_dims(file_id, dataset_name_, min_dim, max_dim);
   vector<int> blob_dims(dims.size());
   for (int i = 0; i < dims.size(); ++i) {
     blob_dims[i] = dims[i];
@@ -81,6 +90,74 @@ void hdf5_load_nd_dataset<double>(hid_t file_id, const char* dataset_name_,
   CHECK_GE(status, 0) << "Failed to read double dataset " << dataset_name_;
 }
 
+template <typename Dtype>
+static void hdf5_read_rows(
+    hid_t file_id, const char* dataset_name_, hsize_t begin, hsize_t count,
+    int min_dim, int max_dim, hid_t mem_type, Blob<Dtype>* blob) {
+  // Only the requested rows are allocated, so datasets larger than memory
+  // can be read a chunk at a time.
+  const std::vector<hsize_t> dataset_dims =
+      hdf5_get_dataset_dims(file_id, dataset_name_, min_dim, max_dim);
+  CHECK_GE(dataset_dims.size(), 1) << "Dataset " << dataset_name_
+      << " has no rows.";
+  CHECK_LE(begin + count, dataset_dims[0]) << "Rows out of range of dataset "
+      << dataset_name_;
+  vector<int> shape(dataset_dims.size());
+  shape[0] = count;
+  for (int i = 1; i < shape.size(); ++i) {
+    shape[i] = dataset_dims[i];
+  }
+  blob->Reshape(shape);
+  hid_t dataset_id = H5Dopen2(file_id, dataset_name_, H5P_DEFAULT);
+  CHECK_GE(dataset_id, 0) << "Failed to open dataset " << dataset_name_;
+  hid_t file_space = H5Dget_space(dataset_id);
+  std::vector<hsize_t> offset(shape.size(), 0), dims(shape.size());
+  offset[0] = begin;
+  for (int i = 0; i < shape.size(); ++i) {
+    dims[i] = shape[i];
+  }
+  herr_t status = H5Sselect_hyperslab(file_space, H5S_SELECT_SET,
+      offset.data(), NULL, dims.data(), NULL);
+  CHECK_GE(status, 0) << "Failed to select rows of dataset " << dataset_name_;
+  hid_t mem_space = H5Screate_simple(dims.size(), dims.data(), NULL);
+  status = H5Dread(dataset_id, mem_type, mem_space, file_space, H5P_DEFAULT,
+      blob->mutable_cpu_data());
+  CHECK_GE(status, 0) << "Failed to read rows of dataset " << dataset_name_;
+  H5Sclose(mem_space);
+  H5Sclose(file_space);
+  H5Dclose(dataset_id);
+}
+
+template <>
+void hdf5_load_nd_dataset_rows<float>(hid_t file_id, const char* dataset_name_,
+    hsize_t begin, hsize_t count, int min_dim, int max_dim,
+    Blob<float>* blob) {
+  hdf5_read_rows(file_id, dataset_name_, begin, count, min_dim, max_dim,
+      H5T_NATIVE_FLOAT, blob);
+}
+
+template <>
+void hdf5_load_nd_dataset_rows<double>(hid_t file_id,
+    const char* dataset_name_, hsize_t begin, hsize_t count, int min_dim,
+    int max_dim, Blob<double>* blob) {
+  hdf5_read_rows(file_id, dataset_name_, begin, count, min_dim, max_dim,
+      H5T_NATIVE_DOUBLE, blob);
+}
+
+hsize_t hdf5_get_num_rows(hid_t file_id, const char* dataset_name_) {
+  CHECK(H5LTfind_dataset(file_id, dataset_name_))
+      << "Failed to find HDF5 dataset " << dataset_name_;
+  int ndims;
+  herr_t status = H5LTget_dataset_ndims(file_id, dataset_name_, &ndims);
+  CHECK_GE(status, 0) << "Failed to get dataset ndims for " << dataset_name_;
+  CHECK_GE(ndims, 1) << "Dataset " << dataset_name_ << " has no rows.";
+  std::vector<hsize_t> dims(ndims);
+  status = H5LTget_dataset_info(file_id, dataset_name_, dims.data(), NULL,
+      NULL);
+  CHECK_GE(status, 0) << "Failed to get dataset info for " << dataset_name_;
+  return dims[0];
+}
+
 template <>
 void hdf5_save_nd_dataset<float>(
     const hid_t file_id, const string& dataset_name, const Blob<float>& blob,
@@ -123,6 +200,88 @@ void hdf5_save_nd_dataset<double>(
   delete[] dims;
 }
 
+template <typename Dtype>
+static void hdf5_append_rows(
+    hid_t file_id, const string& dataset_name, const Blob<Dtype>& blob,
+    hsize_t chunk_rows, int compression_level, hid_t type) {
+  const int num_axes = blob.num_axes();
+  CHECK_GE(num_axes, 1) << "Cannot append a blob without rows to dataset "
+      << dataset_name;
+  std::vector<hsize_t> dims(num_axes), offset(num_axes, 0);
+  for (int i = 0; i < num_axes; ++i) {
+    dims[i] = blob.shape(i);
+  }
+  hid_t dataset_id;
+  if (H5LTfind_dataset(file_id, dataset_name.c_str())) {
+    dataset_id = H5Dopen2(file_id, dataset_name.c_str(), H5P_DEFAULT);
+  } else {
+    // Start out empty, with room to grow along the first axis.
+    std::vector<hsize_t> empty_dims(dims), max_dims(dims), chunk_dims(dims);
+    empty_dims[0] = 0;
+    max_dims[0] = H5S_UNLIMITED;
+    chunk_dims[0] = chunk_rows ? chunk_rows : dims[0];
+    for (int i = 0; i < num_axes; ++i) {
+      chunk_dims[i] = std::max(chunk_dims[i], hsize_t(1));
+    }
+    hid_t space = H5Screate_simple(num_axes, empty_dims.data(),
+        max_dims.data());
+    hid_t create_plist = H5Pcreate(H5P_DATASET_CREATE);
+    herr_t status = H5Pset_chunk(create_plist, num_axes, chunk_dims.data());
+    CHECK_GE(status, 0) << "Failed to set chunks of dataset " << dataset_name;
+    if (compression_level) {
+      status = H5Pset_deflate(create_plist, compression_level);
+      CHECK_GE(status, 0) << "Failed to set compression of dataset "
+          << dataset_name;
+    }
+    dataset_id = H5Dcreate2(file_id, dataset_name.c_str(), type, space,
+        H5P_DEFAULT, create_plist, H5P_DEFAULT);
+    H5Pclose(create_plist);
+    H5Sclose(space);
+  }
+  CHECK_GE(dataset_id, 0) << "Failed to open dataset " << dataset_name;
+  hid_t file_space = H5Dget_space(dataset_id);
+  CHECK_EQ(H5Sget_simple_extent_ndims(file_space), num_axes)
+      << "Rows don't match the shape of dataset " << dataset_name;
+  std::vector<hsize_t> file_dims(num_axes);
+  H5Sget_simple_extent_dims(file_space, file_dims.data(), NULL);
+  H5Sclose(file_space);
+  for (int i = 1; i < num_axes; ++i) {
+    CHECK_EQ(file_dims[i], dims[i])
+        << "Rows don't match the shape of dataset " << dataset_name;
+  }
+  offset[0] = file_dims[0];
+  file_dims[0] += dims[0];
+  herr_t status = H5Dset_extent(dataset_id, file_dims.data());
+  CHECK_GE(status, 0) << "Failed to extend dataset " << dataset_name;
+  file_space = H5Dget_space(dataset_id);
+  status = H5Sselect_hyperslab(file_space, H5S_SELECT_SET, offset.data(),
+      NULL, dims.data(), NULL);
+  CHECK_GE(status, 0) << "Failed to select rows of dataset " << dataset_name;
+  hid_t mem_space = H5Screate_simple(num_axes, dims.data(), NULL);
+  status = H5Dwrite(dataset_id, type, mem_space, file_space, H5P_DEFAULT,
+      blob.cpu_data());
+  CHECK_GE(status, 0) << "Failed to append rows to dataset " << dataset_name;
+  H5Sclose(mem_space);
+  H5Sclose(file_space);
+  H5Dclose(dataset_id);
+}
+
+template <>
+void hdf5_append_nd_dataset<float>(
+    hid_t file_id, const string& dataset_name, const Blob<float>& blob,
+    hsize_t chunk_rows, int compression_level) {
+  hdf5_append_rows(file_id, dataset_name, blob, chunk_rows, compression_level,
+      H5T_NATIVE_FLOAT);
+}
+
+template <>
+void hdf5_append_nd_dataset<double>(
+    hid_t file_id, const string& dataset_name, const Blob<double>& blob,
+    hsize_t chunk_rows, int compression_level) {
+  hdf5_append_rows(file_id, dataset_name, blob, chunk_rows, compression_level,
+      H5T_NATIVE_DOUBLE);
+}
+
 string hdf5_load_string(hid_t loc_id, const string& dataset_name) {
   // Get size of dataset
   size_t size;
@@ -184,4 +343,14 @@ string hdf5_get_name_by_idx(hid_t loc_id, int idx) {
   return result;
 }
 
+static boost::recursive_mutex hdf5_mutex_;
+
+HDF5Lock::HDF5Lock() {
+  hdf5_mutex_.lock();
+}
+
+HDF5Lock::~HDF5Lock() {
+  hdf5_mutex_.unlock();
+}
+
 }  // namespace caffe
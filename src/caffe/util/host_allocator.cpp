@@ -0,0 +1,90 @@
+#include <boost/thread.hpp>
+#include <stdlib.h>
+
+#include <map>
+#include <vector>
+
+#include "caffe/util/host_allocator.hpp"
+
+namespace caffe {
+
+typedef std::map<size_t, vector<void*> > FreeBlocks;
+
+// The state is never destroyed, as SyncedMemory held by static or thread
+// local objects may still be freed during exit.
+static boost::mutex* host_allocator_mutex_ = new boost::mutex();
+// Free blocks by size class.
+static FreeBlocks* free_blocks_ = new FreeBlocks();
+static HostAllocator::Stats stats_ = { 0, 0, 0, 0 };
+
+size_t HostAllocator::SizeClass(size_t size) {
+  if (size <= kAlignment) {
+    return kAlignment;
+  }
+  // Four classes between consecutive powers of two, in kAlignment steps.
+  int log2 = 0;
+  while ((size - 1) >> (log2 + 1)) {
+    ++log2;
+  }
+  size_t step = static_cast<size_t>(1) << (log2 < 2 ? 0 : log2 - 2);
+  if (step < kAlignment) {
+    step = kAlignment;
+  }
+  return (size + step - 1) / step * step;
+}
+
+void* HostAllocator::Allocate(size_t size) {
+  const size_t bytes = SizeClass(size);
+  {
+    boost::mutex::scoped_lock lock(*host_allocator_mutex_);
+    stats_.bytes_in_use += bytes;
+    vector<void*>& blocks = (*free_blocks_)[bytes];
+    if (!blocks.empty()) {
+      void* ptr = blocks.back();
+      blocks.pop_back();
+      stats_.bytes_cached -= bytes;
+      ++stats_.hits;
+      return ptr;
+    }
+    ++stats_.misses;
+  }
+  void* ptr = NULL;
+  if (posix_memalign(&ptr, kAlignment, bytes) != 0) {
+    // Cached blocks of other classes may be what stands in the way.
+    ReleaseCached();
+    CHECK_EQ(posix_memalign(&ptr, kAlignment, bytes), 0)
+        << "host allocation of size " << size << " failed";
+  }
+  return ptr;
+}
+
+void HostAllocator::Free(void* ptr, size_t size) {
+  if (!ptr) {
+    return;
+  }
+  const size_t bytes = SizeClass(size);
+  boost::mutex::scoped_lock lock(*host_allocator_mutex_);
+  CHECK_GE(stats_.bytes_in_use, bytes);
+  stats_.bytes_in_use -= bytes;
+  (*free_blocks_)[bytes].push_back(ptr);
+  stats_.bytes_cached += bytes;
+}
+
+void HostAllocator::ReleaseCached() {
+  boost::mutex::scoped_lock lock(*host_allocator_mutex_);
+  for (FreeBlocks::iterator it = free_blocks_->begin();
+       it != free_blocks_->end(); ++it) {
+    for (int i = 0; i < it->second.size(); ++i) {
+      free(it->second[i]);
+    }
+  }
+  free_blocks_->clear();
+  stats_.bytes_cached = 0;
+}
+
+HostAllocator::Stats HostAllocator::stats() {
+  boost::mutex::scoped_lock lock(*host_allocator_mutex_);
+  return stats_;
+}
+
+}  // namespace caffe
@@ -0,0 +1,114 @@
+#ifdef USE_OPENCV
+#include <boost/thread.hpp>
+#include <opencv2/core/core.hpp>
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+
+#include "caffe/util/image_cache.hpp"
+#include "caffe/util/io.hpp"
+
+namespace caffe {
+
+static size_t ImageBytes(const cv::Mat& image) {
+  return image.total() * image.elemSize();
+}
+
+ImageCache::ImageCache(size_t capacity)
+    : capacity_(capacity), size_(0), hits_(0), misses_(0),
+      mutex_(new boost::mutex()) {
+}
+
+ImageCache& ImageCache::Get() {
+  static ImageCache cache(0);
+  return cache;
+}
+
+bool ImageCache::Lookup(const string& key, cv::Mat* image) {
+  boost::mutex::scoped_lock lock(*mutex_);
+  Images::iterator it = images_.find(key);
+  if (it == images_.end()) {
+    ++misses_;
+    return false;
+  }
+  ++hits_;
+  recency_.splice(recency_.begin(), recency_, it->second.second);
+  *image = it->second.first;
+  return true;
+}
+
+void ImageCache::Insert(const string& key, const cv::Mat& image) {
+  const size_t bytes = ImageBytes(image);
+  boost::mutex::scoped_lock lock(*mutex_);
+  if (bytes > capacity_ || images_.count(key)) {
+    return;
+  }
+  Evict(capacity_ - bytes);
+  recency_.push_front(key);
+  // Keep a continuous copy, so the cache owns all of its memory even when
+  // image is a view into a larger one.
+  images_[key] = std::make_pair(image.isContinuous() ? image : image.clone(),
+      recency_.begin());
+  size_ += bytes;
+}
+
+void ImageCache::Reserve(size_t capacity) {
+  boost::mutex::scoped_lock lock(*mutex_);
+  capacity_ = std::max(capacity_, capacity);
+}
+
+void ImageCache::Clear() {
+  boost::mutex::scoped_lock lock(*mutex_);
+  Evict(0);
+  hits_ = misses_ = 0;
+}
+
+void ImageCache::Evict(size_t capacity) {
+  while (size_ > capacity) {
+    Images::iterator it = images_.find(recency_.back());
+    size_ -= ImageBytes(it->second.first);
+    images_.erase(it);
+    recency_.pop_back();
+  }
+}
+
+size_t ImageCache::capacity() const {
+  boost::mutex::scoped_lock lock(*mutex_);
+  return capacity_;
+}
+
+size_t ImageCache::size() const {
+  boost::mutex::scoped_lock lock(*mutex_);
+  return size_;
+}
+
+size_t ImageCache::hits() const {
+  boost::mutex::scoped_lock lock(*mutex_);
+  return hits_;
+}
+
+size_t ImageCache::misses() const {
+  boost::mutex::scoped_lock lock(*mutex_);
+  return misses_;
+}
+
+cv::Mat ReadImageToCVMat(const string& filename, const int height,
+    const int width, const bool is_color, ImageCache* cache) {
+  if (!cache) {
+    return ReadImageToCVMat(filename, height, width, is_color);
+  }
+  std::ostringstream key;
+  key << filename << ':' << height << 'x' << width << (is_color ? 'c' : 'g');
+  cv::Mat cv_img;
+  if (!cache->Lookup(key.str(), &cv_img)) {
+    cv_img = ReadImageToCVMat(filename, height, width, is_color);
+    if (cv_img.data) {
+      cache->Insert(key.str(), cv_img);
+    }
+  }
+  return cv_img;
+}
+
+}  // namespace caffe
+#endif  // USE_OPENCV
@@ -9,8 +9,10 @@
 #include <opencv2/imgproc/imgproc.hpp>
 #endif  // USE_OPENCV
 #include <stdint.h>
+#include <unistd.h>
 
 #include <algorithm>
+#include <cstdio>
 #include <fstream>  // NOLINT(readability/streams)
 #include <string>
 #include <vector>
@@ -69,6 +71,28 @@ void WriteProtoToBinaryFile(const Message& proto, const char* filename) {
   CHECK(proto.SerializeToOstream(&output));
 }
 
+void WriteProtoToBinaryFileAtomic(const Message& proto,
+    const string& filename) {
+  const string temp_filename = filename + ".tmp";
+  int fd = open(temp_filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  CHECK_NE(fd, -1) << "Failed to open " << temp_filename;
+  FileOutputStream* output = new FileOutputStream(fd);
+  CHECK(proto.SerializeToZeroCopyStream(output));
+  CHECK(output->Flush()) << "Failed to write " << temp_filename;
+  delete output;
+  CHECK_EQ(fsync(fd), 0) << "Failed to sync " << temp_filename;
+  CHECK_EQ(close(fd), 0) << "Failed to close " << temp_filename;
+  CHECK_EQ(rename(temp_filename.c_str(), filename.c_str()), 0)
+      << "Failed to rename " << temp_filename << " to " << filename;
+  // Sync the directory too, so that the rename itself survives a crash.
+  string dirname = boost::filesystem::path(filename).parent_path().string();
+  int dir_fd = open(dirname.empty() ? "." : dirname.c_str(), O_RDONLY);
+  if (dir_fd != -1) {
+    fsync(dir_fd);
+    close(dir_fd);
+  }
+}
+
 #ifdef USE_OPENCV
 cv::Mat ReadImageToCVMat(const string& filename,
     const int height, const int width, const bool is_color) {
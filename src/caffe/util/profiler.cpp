@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>  // NOLINT(readability/streams)
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include "caffe/util/profiler.hpp"
+
+namespace caffe {
+
+Profiler::Profiler(const vector<string>& layer_names,
+    const vector<string>& layer_types)
+    : layer_stats_(layer_names.size()), begin_us_(0) {
+  CHECK_EQ(layer_names.size(), layer_types.size());
+  for (int i = 0; i < layer_stats_.size(); ++i) {
+    layer_stats_[i].name = layer_names[i];
+    layer_stats_[i].type = layer_types[i];
+  }
+  Reset();
+}
+
+void Profiler::Reset() {
+  for (int i = 0; i < layer_stats_.size(); ++i) {
+    LayerStats& stats = layer_stats_[i];
+    stats.forward_calls = stats.backward_calls = 0;
+    stats.forward_us = stats.backward_us = 0;
+    stats.forward_flops = stats.forward_bytes = 0;
+  }
+  events_.clear();
+  epoch_ = boost::posix_time::microsec_clock::local_time();
+}
+
+void Profiler::LayerBegin() {
+  begin_us_ = (boost::posix_time::microsec_clock::local_time() - epoch_)
+      .total_microseconds();
+  timer_.Start();
+}
+
+void Profiler::LayerEnd(int layer, bool forward, double flops,
+    double bytes) {
+  const double duration_us = timer_.MicroSeconds();
+  LayerStats& stats = layer_stats_[layer];
+  if (forward) {
+    ++stats.forward_calls;
+    stats.forward_us += duration_us;
+    stats.forward_flops += flops;
+    stats.forward_bytes += bytes;
+  } else {
+    ++stats.backward_calls;
+    stats.backward_us += duration_us;
+  }
+  if (events_.size() < kMaxEvents) {
+    Event event = { layer, forward, begin_us_, duration_us };
+    events_.push_back(event);
+  }
+}
+
+static bool MoreTime(const Profiler::LayerStats* a,
+    const Profiler::LayerStats* b) {
+  return a->forward_us + a->backward_us > b->forward_us + b->backward_us;
+}
+
+string Profiler::Summary() const {
+  vector<const LayerStats*> sorted;
+  double total_us = 0;
+  for (int i = 0; i < layer_stats_.size(); ++i) {
+    sorted.push_back(&layer_stats_[i]);
+    total_us += layer_stats_[i].forward_us + layer_stats_[i].backward_us;
+  }
+  std::stable_sort(sorted.begin(), sorted.end(), MoreTime);
+  ostringstream summary;
+  summary << std::fixed << std::setprecision(3)
+      << std::left << std::setw(24) << "layer" << std::setw(16) << "type"
+      << std::right << std::setw(12) << "forward ms" << std::setw(12)
+      << "backward ms" << std::setw(8) << "share" << std::setw(10)
+      << "GFLOP/s" << std::setw(10) << "GB/s" << "\n";
+  for (int i = 0; i < sorted.size(); ++i) {
+    const LayerStats& stats = *sorted[i];
+    const double layer_us = stats.forward_us + stats.backward_us;
+    summary << std::left << std::setw(24) << stats.name << std::setw(16)
+        << stats.type << std::right << std::setw(12)
+        << (stats.forward_calls ?
+            stats.forward_us / 1000 / stats.forward_calls : 0)
+        << std::setw(12)
+        << (stats.backward_calls ?
+            stats.backward_us / 1000 / stats.backward_calls : 0)
+        << std::setprecision(1) << std::setw(7)
+        << (total_us > 0 ? 100 * layer_us / total_us : 0) << "%"
+        << std::setprecision(3) << std::setw(10)
+        << (stats.forward_us > 0 ?
+            stats.forward_flops / stats.forward_us / 1e3 : 0)
+        << std::setw(10)
+        << (stats.forward_us > 0 ?
+            stats.forward_bytes / stats.forward_us / 1e3 : 0)
+        << "\n";
+  }
+  summary << "Total time: " << total_us / 1000 << " ms";
+  return summary.str();
+}
+
+static string JsonString(const string& value) {
+  string quoted = "\"";
+  for (int i = 0; i < value.size(); ++i) {
+    const unsigned char c = value[i];
+    if (c == '"' || c == '\\') {
+      quoted += '\\';
+      quoted += c;
+    } else if (c < 0x20) {
+      // Control characters are not allowed raw inside JSON strings.
+      char escaped[7];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      quoted += escaped;
+    } else {
+      quoted += c;
+    }
+  }
+  return quoted + "\"";
+}
+
+void Profiler::WriteChromeTrace(const string& filename) const {
+  std::ofstream file(filename.c_str());
+  CHECK(file.is_open()) << "Failed to open " << filename;
+  file << std::fixed << std::setprecision(1) << "{\"traceEvents\":[";
+  for (int i = 0; i < events_.size(); ++i) {
+    const Event& event = events_[i];
+    const LayerStats& stats = layer_stats_[event.layer];
+    file << (i ? ",\n" : "\n") << "{\"name\":" << JsonString(stats.name)
+        << ",\"cat\":\"" << (event.forward ? "forward" : "backward")
+        << "\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":" << event.begin_us
+        << ",\"dur\":" << event.duration_us << ",\"args\":{\"type\":"
+        << JsonString(stats.type) << "}}";
+  }
+  file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  CHECK(file.good()) << "Failed to write " << filename;
+}
+
+}  // namespace caffe
@@ -0,0 +1,109 @@
+#include <boost/thread.hpp>
+#include <deque>
+#include <vector>
+
+#include "caffe/util/io.hpp"
+#include "caffe/util/snapshot_writer.hpp"
+
+namespace caffe {
+
+class SnapshotWriter::Impl {
+ public:
+  explicit Impl(int max_pending)
+      : max_pending_(max_pending), pending_(0), stop_(false) {
+    CHECK_GT(max_pending, 0) << "At least one snapshot must be allowed in "
+        "flight.";
+    thread_ = boost::thread(&Impl::Run, this);
+  }
+
+  ~Impl() {
+    Flush();
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      stop_ = true;
+    }
+    condition_.notify_all();
+    thread_.join();
+  }
+
+  void Write(const vector<File>& files) {
+    boost::mutex::scoped_lock lock(mutex_);
+    while (pending_ >= max_pending_) {
+      LOG(INFO) << "Waiting for an earlier snapshot to be written";
+      condition_.wait(lock);
+    }
+    queue_.push_back(files);
+    ++pending_;
+    condition_.notify_all();
+  }
+
+  void Flush() {
+    boost::mutex::scoped_lock lock(mutex_);
+    while (pending_ > 0) {
+      condition_.wait(lock);
+    }
+  }
+
+  int pending() const {
+    boost::mutex::scoped_lock lock(mutex_);
+    return pending_;
+  }
+
+ private:
+  void Run() {
+    while (true) {
+      vector<File> files;
+      {
+        boost::mutex::scoped_lock lock(mutex_);
+        while (queue_.empty() && !stop_) {
+          condition_.wait(lock);
+        }
+        if (queue_.empty()) {
+          return;
+        }
+        files.swap(queue_.front());
+        queue_.pop_front();
+      }
+      for (int i = 0; i < files.size(); ++i) {
+        WriteProtoToBinaryFileAtomic(*files[i].first, files[i].second);
+        LOG(INFO) << "Wrote snapshot file " << files[i].second;
+      }
+      // Release the protos before letting Write stage another snapshot.
+      files.clear();
+      {
+        boost::mutex::scoped_lock lock(mutex_);
+        --pending_;
+      }
+      condition_.notify_all();
+    }
+  }
+
+  const int max_pending_;
+  int pending_;
+  bool stop_;
+  std::deque<vector<File> > queue_;
+  mutable boost::mutex mutex_;
+  boost::condition_variable condition_;
+  boost::thread thread_;
+};
+
+SnapshotWriter::SnapshotWriter(int max_pending)
+    : impl_(new Impl(max_pending)) {
+}
+
+SnapshotWriter::~SnapshotWriter() {
+}
+
+void SnapshotWriter::Write(const vector<File>& files) {
+  impl_->Write(files);
+}
+
+void SnapshotWriter::Flush() {
+  impl_->Flush();
+}
+
+int SnapshotWriter::pending() const {
+  return impl_->pending();
+}
+
+}  // namespace caffe
@@ -0,0 +1,206 @@
+#include <boost/thread.hpp>
+#include <algorithm>
+#include <vector>
+
+#include "caffe/util/thread_pool.hpp"
+
+namespace caffe {
+
+// Set on the pool's workers, and on a caller for the duration of its Run, so
+// that a parallel_for issued from inside a body runs serially.
+static boost::thread_specific_ptr<bool> in_parallel_region_;
+
+static bool in_parallel_region() {
+  return in_parallel_region_.get() && *in_parallel_region_;
+}
+
+class ThreadPool::Impl {
+ public:
+  explicit Impl(int num_workers);
+  ~Impl();
+
+  int num_workers() const { return workers_.size(); }
+  void Run(int begin, int end, int grain, const Body& body);
+
+ private:
+  // One participant's share of the current range; [begin, end) is the part
+  // that nobody has claimed yet.
+  struct Block {
+    boost::mutex mutex;
+    int begin, end;
+  };
+
+  void WorkerEntry(int worker_id);
+  // Work through block self, then steal from the others until all are empty.
+  void Participate(int self);
+  bool Claim(int block, bool from_front, int* chunk_begin, int* chunk_end);
+
+  vector<shared_ptr<boost::thread> > workers_;
+  vector<shared_ptr<Block> > blocks_;
+  // Held for the duration of a Run; a concurrent Run runs serially instead.
+  boost::mutex run_mutex_;
+  // Guards the fields below, which describe the current Run.
+  boost::mutex mutex_;
+  boost::condition_variable start_;
+  boost::condition_variable done_;
+  unsigned int generation_;
+  int participants_;
+  int pending_;
+  bool stop_;
+  const Body* body_;
+  int grain_;
+};
+
+ThreadPool::Impl::Impl(int num_workers)
+    : generation_(0), participants_(0), pending_(0), stop_(false),
+      body_(NULL), grain_(1) {
+  for (int i = 0; i < num_workers + 1; ++i) {
+    blocks_.push_back(shared_ptr<Block>(new Block()));
+  }
+  try {
+    for (int i = 0; i < num_workers; ++i) {
+      workers_.push_back(shared_ptr<boost::thread>(
+          new boost::thread(&ThreadPool::Impl::WorkerEntry, this, i)));
+    }
+  } catch (std::exception& e) {
+    LOG(FATAL) << "Thread exception: " << e.what();
+  }
+}
+
+ThreadPool::Impl::~Impl() {
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    stop_ = true;
+  }
+  start_.notify_all();
+  for (int i = 0; i < workers_.size(); ++i) {
+    workers_[i]->join();
+  }
+}
+
+void ThreadPool::Impl::WorkerEntry(int worker_id) {
+  in_parallel_region_.reset(new bool(true));
+  unsigned int seen = 0;
+  while (true) {
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      while (!stop_ && generation_ == seen) {
+        start_.wait(lock);
+      }
+      if (stop_) {
+        return;
+      }
+      seen = generation_;
+      // Block 0 belongs to the caller, so worker i owns block i + 1.
+      if (worker_id + 1 >= participants_) {
+        continue;
+      }
+    }
+    Participate(worker_id + 1);
+    {
+      boost::mutex::scoped_lock lock(mutex_);
+      if (--pending_ == 0) {
+        done_.notify_one();
+      }
+    }
+  }
+}
+
+bool ThreadPool::Impl::Claim(int block, bool from_front, int* chunk_begin,
+    int* chunk_end) {
+  Block& b = *blocks_[block];
+  boost::mutex::scoped_lock lock(b.mutex);
+  if (b.begin >= b.end) {
+    return false;
+  }
+  if (from_front) {
+    *chunk_begin = b.begin;
+    *chunk_end = std::min(b.begin + grain_, b.end);
+    b.begin = *chunk_end;
+  } else {
+    *chunk_end = b.end;
+    *chunk_begin = std::max(b.end - grain_, b.begin);
+    b.end = *chunk_begin;
+  }
+  return true;
+}
+
+void ThreadPool::Impl::Participate(int self) {
+  int chunk_begin, chunk_end;
+  while (Claim(self, true, &chunk_begin, &chunk_end)) {
+    (*body_)(chunk_begin, chunk_end);
+  }
+  for (int i = 1; i < participants_; ++i) {
+    const int victim = (self + i) % participants_;
+    while (Claim(victim, false, &chunk_begin, &chunk_end)) {
+      (*body_)(chunk_begin, chunk_end);
+    }
+  }
+}
+
+void ThreadPool::Impl::Run(int begin, int end, int grain, const Body& body) {
+  grain = std::max(grain, 1);
+  const int num_chunks = (end - begin + grain - 1) / grain;
+  const int participants = std::min(num_workers() + 1, num_chunks);
+  if (participants <= 1 || in_parallel_region() || !run_mutex_.try_lock()) {
+    body(begin, end);
+    return;
+  }
+  boost::mutex::scoped_lock run_lock(run_mutex_, boost::adopt_lock);
+  // Split the range into whole chunks, as evenly as possible.
+  for (int i = 0; i < participants; ++i) {
+    Block& b = *blocks_[i];
+    boost::mutex::scoped_lock lock(b.mutex);
+    const int64_t first_chunk = int64_t(num_chunks) * i / participants;
+    const int64_t last_chunk = int64_t(num_chunks) * (i + 1) / participants;
+    b.begin = begin + first_chunk * grain;
+    b.end = std::min<int64_t>(begin + last_chunk * grain, end);
+  }
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    body_ = &body;
+    grain_ = grain;
+    participants_ = participants;
+    pending_ = participants - 1;
+    ++generation_;
+  }
+  start_.notify_all();
+  in_parallel_region_.reset(new bool(true));
+  Participate(0);
+  in_parallel_region_.reset(new bool(false));
+  boost::mutex::scoped_lock lock(mutex_);
+  while (pending_ > 0) {
+    done_.wait(lock);
+  }
+  body_ = NULL;
+}
+
+ThreadPool::ThreadPool(int num_threads) {
+  Resize(num_threads);
+}
+
+ThreadPool::~ThreadPool() { }
+
+int ThreadPool::num_threads() const {
+  return impl_->num_workers() + 1;
+}
+
+void ThreadPool::Resize(int num_threads) {
+  CHECK_GE(num_threads, 1) << "A thread pool needs at least one thread.";
+  impl_.reset();
+  impl_.reset(new Impl(num_threads - 1));
+}
+
+void ThreadPool::Run(int begin, int end, int grain, const Body& body) {
+  if (end <= begin) {
+    return;
+  }
+  impl_->Run(begin, end, grain, body);
+}
+
+void parallel_for(const int begin, const int end,
+    const ThreadPool::Body& body, const int grain) {
+  Caffe::thread_pool().Run(begin, end, grain, body);
+}
+
+}  // namespace caffe
@@ -40,6 +40,12 @@ DEFINE_string(weights, "",
     "separated by ','. Cannot be set simultaneously with snapshot.");
 DEFINE_int32(iterations, 50,
     "The number of iterations to run.");
+DEFINE_int32(cpu_threads, 1,
+    "Optional; the number of threads CPU layers split their work across.");
+DEFINE_int32(workers, 1,
+    "Optional; the number of solvers to train data-parallel on the CPU, each "
+    "on its own thread. The effective training batch size is multiplied by "
+    "the number of workers.");
 DEFINE_string(sigint_effect, "stop",
              "Optional; action to take when a SIGINT signal is received: "
               "snapshot, stop or none.");
@@ -173,10 +179,14 @@ int train() {
 
   vector<int> gpus;
   get_gpus(&gpus);
+  CHECK_GE(FLAGS_workers, 1) << "Need at least one worker.";
   if (gpus.size() == 0) {
     LOG(INFO) << "Use CPU.";
     Caffe::set_mode(Caffe::CPU);
+    Caffe::set_solver_count(FLAGS_workers);
   } else {
+    CHECK_EQ(FLAGS_workers, 1) << "Use -gpu to train on several GPUs; "
+        "-workers only applies to CPU training.";
     ostringstream s;
     for (int i = 0; i < gpus.size(); ++i) {
       s << (i ? ", " : "") << gpus[i];
@@ -208,6 +218,9 @@ int train() {
   if (gpus.size() > 1) {
     caffe::P2PSync<float> sync(solver, NULL, solver->param());
     sync.run(gpus);
+  } else if (FLAGS_workers > 1) {
+    caffe::CPUSync<float> sync(solver);
+    sync.run(FLAGS_workers);
   } else {
     LOG(INFO) << "Starting Optimization";
     solver->Solve();
@@ -388,6 +401,7 @@ int main(int argc, char** argv) {
       "  time            benchmark model execution time");
   // Run tool or show usage.
   caffe::GlobalInit(&argc, &argv);
+  Caffe::set_cpu_threads(FLAGS_cpu_threads);
   if (argc == 2) {
 #ifdef WITH_PYTHON_LAYER
     try {
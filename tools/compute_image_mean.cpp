@@ -19,7 +19,7 @@ using std::pair;
 using boost::scoped_ptr;
 
 DEFINE_string(backend, "lmdb",
-        "The backend {leveldb, lmdb} containing the images");
+        "The backend {leveldb, lmdb, record} containing the images");
 
 int main(int argc, char** argv) {
   ::google::InitGoogleLogging(argv[0]);
@@ -49,7 +49,7 @@ int main(int argc, char** argv) {
   int count = 0;
   // load first datum
   Datum datum;
-  datum.ParseFromString(cursor->value());
+  cursor->ParseDatum(&datum);
 
   if (DecodeDatumNative(&datum)) {
     LOG(INFO) << "Decoding Datum";
@@ -68,7 +68,7 @@ int main(int argc, char** argv) {
   LOG(INFO) << "Starting Iteration";
   while (cursor->valid()) {
     Datum datum;
-    datum.ParseFromString(cursor->value());
+    cursor->ParseDatum(&datum);
     DecodeDatumNative(&datum);
 
     const std::string& data = datum.data();
@@ -0,0 +1,54 @@
+// This program folds the BatchNorm layers of a trained net into the
+// Convolution and InnerProduct layers before them, and its ReLU layers into
+// the Convolution layers before them (see caffe/util/fold_batch_norm.hpp),
+// to make a deploy net that does fewer passes over its activations.
+// Usage:
+//    fold_batch_norm deploy_net_proto_in trained_weights_in
+//        deploy_net_proto_out trained_weights_out
+
+#include <string>
+#include <vector>
+
+#include "caffe/caffe.hpp"
+#include "caffe/util/fold_batch_norm.hpp"
+#include "caffe/util/io.hpp"
+#include "caffe/util/upgrade_proto.hpp"
+
+using namespace caffe;  // NOLINT(build/namespaces)
+
+int main(int argc, char** argv) {
+  ::google::InitGoogleLogging(argv[0]);
+  FLAGS_alsologtostderr = 1;
+  if (argc != 5) {
+    LOG(ERROR) << "Usage: fold_batch_norm deploy_net_proto_in "
+        << "trained_weights_in deploy_net_proto_out trained_weights_out";
+    return 1;
+  }
+  NetParameter param;
+  ReadNetParamsFromTextFileOrDie(argv[1], &param);
+  param.mutable_state()->set_phase(TEST);
+  Net<float> net(param);
+  net.CopyTrainedLayersFrom(argv[2]);
+  // Attach the trained blobs to the layers they belong to.
+  for (int i = 0; i < param.layer_size(); ++i) {
+    LayerParameter* layer_param = param.mutable_layer(i);
+    const shared_ptr<Layer<float> > layer =
+        net.layer_by_name(layer_param->name());
+    if (!layer) { continue; }
+    layer_param->clear_blobs();
+    for (int j = 0; j < layer->blobs().size(); ++j) {
+      layer->blobs()[j]->ToProto(layer_param->add_blobs());
+    }
+  }
+  NetParameter folded;
+  FoldBatchNorm(param, &folded);
+  LOG(INFO) << "Folded " << param.layer_size() - folded.layer_size()
+      << " layers.";
+  WriteProtoToBinaryFile(folded, argv[4]);
+  for (int i = 0; i < folded.layer_size(); ++i) {
+    folded.mutable_layer(i)->clear_blobs();
+  }
+  WriteProtoToTextFile(folded, argv[3]);
+  LOG(INFO) << "Wrote " << argv[3] << " and " << argv[4];
+  return 0;
+}
@@ -0,0 +1,77 @@
+// This program times BoundedQueue against BlockingQueue, passing items from
+// producer threads to consumer threads through a free and a full queue, as
+// the prefetch paths do.
+// Usage:
+//    queue_benchmark [--producers=1 --consumers=1 --capacity=16 ...]
+
+#include <boost/thread.hpp>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+
+#include "caffe/common.hpp"
+#include "caffe/util/benchmark.hpp"
+#include "caffe/util/blocking_queue.hpp"
+#include "caffe/util/bounded_queue.hpp"
+
+using namespace caffe;  // NOLINT(build/namespaces)
+
+DEFINE_int32(producers, 1, "The number of threads filling items.");
+DEFINE_int32(consumers, 1, "The number of threads taking the filled items.");
+DEFINE_int32(capacity, 16, "The number of items passed around.");
+DEFINE_int32(iterations, 1000000, "The number of items each producer fills.");
+
+// Moves items from the free queue to the full queue, or back.
+template <typename Queue>
+static void Pass(Queue* from, Queue* to, int count) {
+  for (int i = 0; i < count; ++i) {
+    to->push(from->pop());
+  }
+}
+
+// Returns the items passed per second, one item being a push and a pop on
+// each queue.
+template <typename Queue>
+static double Time(Queue* free, Queue* full) {
+  for (int i = 0; i < FLAGS_capacity; ++i) {
+    free->push(i);
+  }
+  const int items = FLAGS_producers * FLAGS_iterations;
+  CHECK_EQ(items % FLAGS_consumers, 0)
+      << "The consumers must share the items evenly.";
+  CPUTimer timer;
+  timer.Start();
+  boost::thread_group threads;
+  for (int i = 0; i < FLAGS_producers; ++i) {
+    threads.create_thread(boost::bind(&Pass<Queue>, free, full,
+        FLAGS_iterations));
+  }
+  for (int i = 0; i < FLAGS_consumers; ++i) {
+    threads.create_thread(boost::bind(&Pass<Queue>, full, free,
+        items / FLAGS_consumers));
+  }
+  threads.join_all();
+  return items / timer.Seconds();
+}
+
+int main(int argc, char** argv) {
+  ::google::InitGoogleLogging(argv[0]);
+  FLAGS_alsologtostderr = 1;
+#ifndef GFLAGS_GFLAGS_H_
+  namespace gflags = google;
+#endif
+  gflags::SetUsageMessage("Times BoundedQueue against BlockingQueue.\n"
+      "Usage:\n"
+      "    queue_benchmark [FLAGS]\n");
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  BlockingQueue<int> blocking_free, blocking_full;
+  const double blocking = Time(&blocking_free, &blocking_full);
+  BoundedQueue<int> bounded_free(FLAGS_capacity), bounded_full(FLAGS_capacity);
+  const double bounded = Time(&bounded_free, &bounded_full);
+  LOG(INFO) << FLAGS_producers << " producers, " << FLAGS_consumers
+      << " consumers, " << FLAGS_capacity << " items: BlockingQueue "
+      << blocking << " ops/s, BoundedQueue " << bounded << " ops/s, "
+      << bounded / blocking << "x faster";
+  return 0;
+}
@@ -0,0 +1,163 @@
+// This program times DataTransformer on uint8 Datums against the original
+// pixel-at-a-time loop, for the common combinations of mean, crop and
+// mirror, and checks that both give the same result.
+// Usage:
+//    transform_benchmark [--channels=3 --height=256 --width=256 ...]
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+
+#include "caffe/blob.hpp"
+#include "caffe/common.hpp"
+#include "caffe/data_transformer.hpp"
+#include "caffe/proto/caffe.pb.h"
+#include "caffe/util/benchmark.hpp"
+#include "caffe/util/io.hpp"
+#include "caffe/util/math_functions.hpp"
+
+using namespace caffe;  // NOLINT(build/namespaces)
+
+DEFINE_int32(channels, 3, "The channels of the benchmark images.");
+DEFINE_int32(height, 256, "The height of the benchmark images.");
+DEFINE_int32(width, 256, "The width of the benchmark images.");
+DEFINE_int32(crop_size, 227, "The crop size of the cropping benchmarks.");
+DEFINE_int32(iterations, 1000, "The number of images to transform.");
+
+// The transformation as DataTransformer did it before it worked on rows;
+// the crop is at (h_off, w_off).
+static void ReferenceTransform(const Datum& datum, const float* mean,
+    const vector<float>& mean_values, float scale, int crop_size, int h_off,
+    int w_off, bool do_mirror, float* transformed_data) {
+  const string& data = datum.data();
+  const int datum_channels = datum.channels();
+  const int datum_height = datum.height();
+  const int datum_width = datum.width();
+  const int height = crop_size ? crop_size : datum_height;
+  const int width = crop_size ? crop_size : datum_width;
+  float datum_element;
+  int top_index, data_index;
+  for (int c = 0; c < datum_channels; ++c) {
+    for (int h = 0; h < height; ++h) {
+      for (int w = 0; w < width; ++w) {
+        data_index = (c * datum_height + h_off + h) * datum_width + w_off + w;
+        if (do_mirror) {
+          top_index = (c * height + h) * width + (width - 1 - w);
+        } else {
+          top_index = (c * height + h) * width + w;
+        }
+        datum_element =
+            static_cast<float>(static_cast<uint8_t>(data[data_index]));
+        if (mean) {
+          transformed_data[top_index] =
+              (datum_element - mean[data_index]) * scale;
+        } else {
+          if (mean_values.size() > 0) {
+            transformed_data[top_index] =
+                (datum_element - mean_values[c]) * scale;
+          } else {
+            transformed_data[top_index] = datum_element * scale;
+          }
+        }
+      }
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  ::google::InitGoogleLogging(argv[0]);
+  FLAGS_alsologtostderr = 1;
+#ifndef GFLAGS_GFLAGS_H_
+  namespace gflags = google;
+#endif
+  gflags::SetUsageMessage("Times DataTransformer on uint8 Datums.\n"
+      "Usage:\n"
+      "    transform_benchmark [FLAGS]\n");
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  Datum datum;
+  datum.set_channels(FLAGS_channels);
+  datum.set_height(FLAGS_height);
+  datum.set_width(FLAGS_width);
+  const int count = FLAGS_channels * FLAGS_height * FLAGS_width;
+  string* data = datum.mutable_data();
+  BlobProto mean_proto;
+  mean_proto.set_num(1);
+  mean_proto.set_channels(FLAGS_channels);
+  mean_proto.set_height(FLAGS_height);
+  mean_proto.set_width(FLAGS_width);
+  for (int i = 0; i < count; ++i) {
+    data->push_back(static_cast<char>(caffe_rng_rand() % 256));
+    mean_proto.add_data(caffe_rng_rand() % 256);
+  }
+  string mean_file;
+  MakeTempFilename(&mean_file);
+  WriteProtoToBinaryFile(mean_proto, mean_file);
+  Blob<float> mean_blob;
+  mean_blob.FromProto(mean_proto);
+
+  const char* names[] = { "scale", "mean_value", "mean_file",
+      "mean_value crop", "mean_value crop mirror", "mean_file crop mirror" };
+  for (int config = 0; config < 6; ++config) {
+    TransformationParameter param;
+    param.set_scale(0.017);
+    const bool use_mean_file = config == 2 || config == 5;
+    if (use_mean_file) {
+      param.set_mean_file(mean_file);
+    } else if (config > 0) {
+      for (int c = 0; c < FLAGS_channels; ++c) {
+        param.add_mean_value(104 + 13 * c);
+      }
+    }
+    if (config >= 3) {
+      param.set_crop_size(FLAGS_crop_size);
+    }
+    // Checked below, without mirroring.
+    DataTransformer<float> transformer(param, TEST);
+    transformer.InitRand();
+    const bool mirror = config >= 4;
+    param.set_mirror(mirror);
+    DataTransformer<float> timed(param, TEST);
+    timed.InitRand();
+    const int crop_size = param.crop_size();
+    const int height = crop_size ? crop_size : FLAGS_height;
+    const int width = crop_size ? crop_size : FLAGS_width;
+    const int h_off = (FLAGS_height - height) / 2;
+    const int w_off = (FLAGS_width - width) / 2;
+    Blob<float> transformed(1, FLAGS_channels, height, width);
+    Blob<float> reference(1, FLAGS_channels, height, width);
+    vector<float> mean_values(param.mean_value().begin(),
+        param.mean_value().end());
+    const float* mean = use_mean_file ? mean_blob.cpu_data() : NULL;
+
+    CPUTimer timer;
+    timer.Start();
+    for (int i = 0; i < FLAGS_iterations; ++i) {
+      // DataTransformer mirrors half of the images, at random.
+      ReferenceTransform(datum, mean, mean_values, param.scale(), crop_size,
+          h_off, w_off, mirror && i % 2, reference.mutable_cpu_data());
+    }
+    const double reference_ms = timer.MilliSeconds() / FLAGS_iterations;
+    timer.Start();
+    for (int i = 0; i < FLAGS_iterations; ++i) {
+      timed.Transform(datum, &transformed);
+    }
+    const double transform_ms = timer.MilliSeconds() / FLAGS_iterations;
+
+    transformer.Transform(datum, &transformed);
+    ReferenceTransform(datum, mean, mean_values, param.scale(), crop_size,
+        h_off, w_off, false, reference.mutable_cpu_data());
+    for (int i = 0; i < transformed.count(); ++i) {
+      CHECK_EQ(transformed.cpu_data()[i], reference.cpu_data()[i])
+          << names[config] << " differs at " << i;
+    }
+    LOG(INFO) << names[config] << ": " << reference_ms << " ms per image "
+        << "pixel by pixel, " << transform_ms << " ms by rows, "
+        << reference_ms / transform_ms << "x faster";
+  }
+  return 0;
+}